@@ -0,0 +1,331 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "collision.h"
+#include "lunarengine.h"
+
+typedef struct {
+    int entities;
+    int properties;
+    int mapW, mapH;
+    float density;
+    int layers;
+    int frames;
+    int warmup;
+    int threads;
+    bool parallelUpdate;
+    bool contactCache;
+    bool parallelDraw;
+    LE_DrawListFormat format;
+    bool spriteCache;
+    unsigned int seed;
+    bool csv;
+} BenchConfig;
+
+typedef struct {
+    const char* name;
+    double* samples;
+} BenchPhase;
+
+enum {
+    PHASE_UPDATE,
+    PHASE_COLLISION,
+    PHASE_DRAW,
+    PHASE_RENDER,
+    PHASE_COUNT
+};
+
+static const char* formatNames[] = { "full", "packed", "quantized" };
+
+static unsigned int rng;
+static unsigned int frameSeed;
+static unsigned long long checksum;
+
+static unsigned int bench_rand() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static float bench_randf() {
+    return (bench_rand() & 0xFFFFFF) / (float)0x1000000;
+}
+
+static double bench_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int bench_compare(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void entity_update(LE_Entity* entity) {
+    LE_EntityProperty dir = LE_EntityGetPropertyOrDefault(entity, (LE_EntityProperty){ .asFloat = 1 }, "p0");
+    entity->velX = 0.05f * dir.asFloat;
+    entity->velY += 0.02f;
+    unsigned int hash = ((unsigned int)(entity->posX * 64) ^ frameSeed) * 2654435761u;
+    if (entity->flags & LE_EntityFlags_OnGround && (hash >> 26) == 0) entity->velY = -0.4f;
+}
+
+static void* entity_texture(LE_Entity* entity, float* width, float* height, int* srcX, int* srcY, int* srcW, int* srcH) {
+    *width = 16;
+    *height = 16;
+    *srcX = 0;
+    *srcY = 0;
+    *srcW = 16;
+    *srcH = 16;
+    return (void*)1;
+}
+
+static int tile_texture(LE_TileData* tile) {
+    return 0;
+}
+
+static void null_renderer(void* texture, float dstX, float dstY, float dstW, float dstH, int srcX, int srcY, int srcW, int srcH, unsigned int color) {
+    checksum = checksum * 31 + (unsigned long long)(long long)(dstX + dstY * 4096) + srcX;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --entities N     number of entities (default 2000)\n"
+        "  --properties M   properties per entity (default 4)\n"
+        "  --map WxH        tilemap size (default 512x64)\n"
+        "  --density D      solid tile density 0..1 (default 0.1)\n"
+        "  --layers L       parallax tilemap layers (default 3)\n"
+        "  --frames F       measured frames (default 500)\n"
+        "  --warmup W       unmeasured frames (default 50)\n"
+        "  --threads T      worker threads (default 0)\n"
+        "  --parallel-update  update thread-safe entities across the worker threads (needs --contact-cache)\n"
+        "  --contact-cache  report collisions through the contact cache\n"
+        "  --parallel-draw  draw layers across the worker threads\n"
+        "  --format F       draw list format: full, packed, quantized (default full)\n"
+        "  --sprite-cache   cache entity texture callback results\n"
+        "  --seed S         random seed (default 1)\n"
+        "  --csv            print CSV instead of JSON\n",
+        argv0
+    );
+}
+
+static bool parse_args(BenchConfig* config, int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--csv") == 0) {
+            config->csv = true;
+            continue;
+        }
+        if (strcmp(arg, "--sprite-cache") == 0) {
+            config->spriteCache = true;
+            continue;
+        }
+        if (strcmp(arg, "--parallel-update") == 0) {
+            config->parallelUpdate = true;
+            continue;
+        }
+        if (strcmp(arg, "--contact-cache") == 0) {
+            config->contactCache = true;
+            continue;
+        }
+        if (strcmp(arg, "--parallel-draw") == 0) {
+            config->parallelDraw = true;
+            continue;
+        }
+        if (!value) return false;
+        i++;
+        if      (strcmp(arg, "--entities")   == 0) config->entities   = atoi(value);
+        else if (strcmp(arg, "--properties") == 0) config->properties = atoi(value);
+        else if (strcmp(arg, "--density")    == 0) config->density    = atof(value);
+        else if (strcmp(arg, "--layers")     == 0) config->layers     = atoi(value);
+        else if (strcmp(arg, "--frames")     == 0) config->frames     = atoi(value);
+        else if (strcmp(arg, "--warmup")     == 0) config->warmup     = atoi(value);
+        else if (strcmp(arg, "--threads")    == 0) config->threads    = atoi(value);
+        else if (strcmp(arg, "--seed")       == 0) config->seed       = strtoul(value, NULL, 10);
+        else if (strcmp(arg, "--format")     == 0) {
+            int format = 0;
+            while (format < 3 && strcmp(value, formatNames[format]) != 0) format++;
+            if (format == 3) return false;
+            config->format = format;
+        }
+        else if (strcmp(arg, "--map")        == 0) {
+            if (sscanf(value, "%dx%d", &config->mapW, &config->mapH) != 2) return false;
+        }
+        else return false;
+    }
+    return config->entities >= 0 && config->properties >= 0 && config->mapW > 2 && config->mapH > 2 && config->layers >= 0 && config->frames > 0;
+}
+
+static void report(BenchConfig* config, BenchPhase* phases) {
+    const char* parallelUpdate = config->parallelUpdate && config->contactCache && config->threads > 0 ? "true" : "false";
+    const char* contactCache = config->contactCache ? "true" : "false";
+    const char* parallelDraw = config->parallelDraw && config->threads > 0 ? "true" : "false";
+    const char* spriteCache = config->spriteCache ? "true" : "false";
+    char settings[256];
+    if (config->csv) {
+        snprintf(settings, sizeof(settings), "%d,%d,%dx%d,%g,%d,%d,%d,%d,%s,%s,%s,%s,%s,%u",
+            config->entities, config->properties, config->mapW, config->mapH, config->density, config->layers, config->frames, config->warmup, config->threads,
+            parallelUpdate, contactCache, parallelDraw, formatNames[config->format], spriteCache, config->seed
+        );
+        printf("entities,properties,map,density,layers,frames,warmup,threads,parallel_update,contact_cache,parallel_draw,format,sprite_cache,seed,phase,median_us,p99_us,mean_us,min_us,max_us\n");
+    }
+    else {
+        printf("{\n  \"config\": {\"entities\": %d, \"properties\": %d, \"map\": \"%dx%d\", \"density\": %g, \"layers\": %d, \"frames\": %d, \"warmup\": %d, \"threads\": %d, \"parallel_update\": %s, \"contact_cache\": %s, \"parallel_draw\": %s, \"format\": \"%s\", \"sprite_cache\": %s, \"seed\": %u},\n",
+            config->entities, config->properties, config->mapW, config->mapH, config->density, config->layers, config->frames, config->warmup, config->threads,
+            parallelUpdate, contactCache, parallelDraw, formatNames[config->format], spriteCache, config->seed
+        );
+        printf("  \"phases\": {\n");
+    }
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        double* samples = phases[i].samples;
+        int count = config->frames;
+        double mean = 0;
+        for (int j = 0; j < count; j++) mean += samples[j];
+        mean /= count;
+        qsort(samples, count, sizeof(double), bench_compare);
+        int p99 = (int)ceil(count * 0.99) - 1;
+        double median = samples[count / 2] * 1e6;
+        if (config->csv) printf("%s,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n", settings, phases[i].name, median, samples[p99] * 1e6, mean * 1e6, samples[0] * 1e6, samples[count - 1] * 1e6);
+        else printf("    \"%s\": {\"median_us\": %.3f, \"p99_us\": %.3f, \"mean_us\": %.3f, \"min_us\": %.3f, \"max_us\": %.3f}%s\n",
+            phases[i].name, median, samples[p99] * 1e6, mean * 1e6, samples[0] * 1e6, samples[count - 1] * 1e6, i == PHASE_COUNT - 1 ? "" : ","
+        );
+    }
+    if (!config->csv) printf("  },\n  \"checksum\": \"%016llx\"\n}\n", checksum);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config = {
+        .entities = 2000,
+        .properties = 4,
+        .mapW = 512, .mapH = 64,
+        .density = 0.1f,
+        .layers = 3,
+        .frames = 500,
+        .warmup = 50,
+        .threads = 0,
+        .seed = 1,
+    };
+    if (!parse_args(&config, argc, argv)) {
+        usage(argv[0]);
+        return 1;
+    }
+    rng = config.seed ? config.seed : 1;
+    LE_SetWorkerThreads(config.threads);
+
+    LE_Tileset* tileset = LE_CreateTileset();
+    LE_TileData* air = LE_CreateTileData();
+    LE_TileData* solid = LE_CreateTileData();
+    LE_TileSetSolid(solid, true);
+    LE_TileAddTextureCallback(solid, tile_texture);
+    LE_TilesetAddTile(tileset, air);
+    LE_TilesetAddTile(tileset, solid);
+    LE_TilesetSetTexture(tileset, (void*)2);
+    LE_TilesetSetTileSize(tileset, 16, 16);
+    LE_TilesetSetTilesInRow(tileset, 16);
+
+    LE_Tilemap* tilemap = LE_CreateTilemap(config.mapW, config.mapH);
+    LE_TilemapSetTileset(tilemap, tileset);
+    for (int y = 0; y < config.mapH; y++) {
+        for (int x = 0; x < config.mapW; x++) {
+            bool border = x == 0 || y == 0 || x == config.mapW - 1 || y == config.mapH - 1;
+            LE_TilemapSetTile(tilemap, x, y, border || bench_randf() < config.density);
+        }
+    }
+
+    LE_EntityBuilder* builder = LE_CreateEntityBuilder();
+    LE_EntityBuilderSetHitboxSize(builder, 0.8f, 0.8f);
+    LE_EntityBuilderAddUpdateCallback(builder, entity_update);
+    LE_EntityBuilderAddTextureCallback(builder, entity_texture);
+    LE_EntityBuilderSetFlags(builder, LE_EntityFlags_SolidHitbox | LE_EntityFlags_ThreadSafe);
+    LE_EntityBuilderSetSpriteCache(builder, config.spriteCache, "p0");
+    for (int i = 0; i < config.properties; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "p%d", i);
+        LE_EntityBuilderSetProperty(builder, (LE_EntityProperty){ .asFloat = 1 }, name);
+    }
+
+    LE_EntityList* entities = LE_CreateEntityList();
+    LE_EntityAssignTilemap(entities, tilemap);
+    LE_EntityListSetParallel(entities, config.parallelUpdate);
+    LE_EntityListSetContactCache(entities, config.contactCache);
+    LE_Entity** all = malloc(sizeof(LE_Entity*) * (config.entities ? config.entities : 1));
+    for (int i = 0; i < config.entities; i++) {
+        int x, y;
+        do {
+            x = 1 + bench_rand() % (config.mapW - 2);
+            y = 1 + bench_rand() % (config.mapH - 2);
+        } while (LE_TilemapGetTile(tilemap, x, y) != 0);
+        all[i] = LE_CreateEntity(entities, builder, x + 0.5f, y + 0.9f);
+        if (bench_rand() & 1) LE_EntitySetProperty(all[i], (LE_EntityProperty){ .asFloat = -1 }, "p0");
+    }
+
+    LE_LayerList* layers = LE_CreateLayerList();
+    LE_LayerListSetParallelDraw(layers, config.parallelDraw);
+    LE_AddEntityLayer(layers, entities);
+    LE_AddTilemapLayer(layers, tilemap);
+    for (int i = 0; i < config.layers; i++) {
+        LE_Layer* layer = LE_AddTilemapLayer(layers, tilemap);
+        layer->scrollSpeedX = layer->scrollSpeedY = 1.f / (i + 2);
+    }
+    LE_DrawList* dl = LE_CreateDrawList();
+    LE_DrawListSetFormat(dl, config.format);
+
+    BenchPhase phases[PHASE_COUNT] = {
+        [PHASE_UPDATE]    = { "update" },
+        [PHASE_COLLISION] = { "collision" },
+        [PHASE_DRAW]      = { "draw" },
+        [PHASE_RENDER]    = { "render" },
+    };
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        phases[i].samples = malloc(sizeof(double) * config.frames);
+    }
+
+    for (int frame = -config.warmup; frame < config.frames; frame++) {
+        frameSeed = bench_rand();
+        double t0 = bench_now();
+        LE_UpdateLayerList(layers);
+        LE_UpdateEntities(entities, 1);
+        double t1 = bench_now();
+        for (int i = 0; i < config.entities; i++) {
+            LE_RunCollisionY(all[i]);
+            LE_RunCollisionX(all[i]);
+        }
+        double t2 = bench_now();
+        float camX = fmodf((frame + config.warmup) * 2.f, config.mapW * 16.f);
+        LE_ScrollCamera(layers, camX, config.mapH * 8.f);
+        LE_ClearDrawList(dl);
+        LE_Draw(layers, 640, 360, 0.5f, dl);
+        double t3 = bench_now();
+        LE_Render(dl, null_renderer);
+        double t4 = bench_now();
+        if (frame < 0) continue;
+        phases[PHASE_UPDATE   ].samples[frame] = t1 - t0;
+        phases[PHASE_COLLISION].samples[frame] = t2 - t1;
+        phases[PHASE_DRAW     ].samples[frame] = t3 - t2;
+        phases[PHASE_RENDER   ].samples[frame] = t4 - t3;
+    }
+
+    report(&config, phases);
+
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        free(phases[i].samples);
+    }
+    free(all);
+    LE_DestroyDrawList(dl);
+    LE_DestroyLayerList(layers);
+    LE_DestroyEntityList(entities);
+    LE_DestroyEntityBuilder(builder);
+    LE_DestroyTilemap(tilemap);
+    LE_DestroyTileset(tileset);
+    LE_DestroyTileData(air);
+    LE_DestroyTileData(solid);
+    LE_SetWorkerThreads(0);
+    return 0;
+}
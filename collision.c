@@ -1,4 +1,10 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "entity.h"
 #include "lunarengine.h"
+#include "profile.h"
+#include "spatial.h"
 
 #define EXPAND(x) x
 #define _CONCAT(a, b) a##b
@@ -36,11 +42,215 @@ bool LE_RectIntersectsRect(
     return x2a > x1b && x2b > x1a && y2a > y1b && y2b > y1a;
 }
 
+bool LE_RayIntersectsRect(
+    float x, float y, float dirX, float dirY, float maxDistance,
+    float x1, float y1, float x2, float y2,
+    float* distance, LE_Direction* direction
+) {
+    float tmin = -INFINITY, tmax = INFINITY;
+    LE_Direction dir = dirX > 0 ? LE_Direction_Left : LE_Direction_Right;
+    if (dirX == 0) {
+        if (x < x1 || x > x2) return false;
+    }
+    else {
+        float t1 = (x1 - x) / dirX;
+        float t2 = (x2 - x) / dirX;
+        tmin = t1 < t2 ? t1 : t2;
+        tmax = t1 < t2 ? t2 : t1;
+    }
+    if (dirY == 0) {
+        if (y < y1 || y > y2) return false;
+    }
+    else {
+        float t1 = (y1 - y) / dirY;
+        float t2 = (y2 - y) / dirY;
+        if (t1 > t2) {
+            float swap = t1;
+            t1 = t2;
+            t2 = swap;
+        }
+        if (t1 > tmin) {
+            tmin = t1;
+            dir = dirY > 0 ? LE_Direction_Up : LE_Direction_Down;
+        }
+        if (t2 < tmax) tmax = t2;
+    }
+    if (tmin < 0) tmin = 0;
+    if (tmax < tmin || tmin > maxDistance) return false;
+    if (distance) *distance = tmin;
+    if (direction) *direction = dir;
+    return true;
+}
+
 void LE_EntitySetPlatform(LE_Entity* entity, LE_Entity* platform);
 
+typedef struct {
+    _LE_EntityListData* data;
+    _LE_Entity* entity;
+    unsigned long long from;
+    unsigned long long nextSeq;
+    float x1, y1, x2, y2;
+    int base;
+} _LE_Broadphase;
+
+static bool _LE_BroadphaseVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_Broadphase* broadphase = userdata;
+    if (entity == broadphase->entity || entity->seq < broadphase->from) return true;
+    if (!LE_ENTITIES_INTERACT(entity, broadphase->entity)) return true;
+    _LE_EntityListData* data = broadphase->data;
+    _LE_PushEntity(&data->candidates, &data->numCandidates, &data->candidateCapacity, entity);
+    return true;
+}
+
+static int _LE_CompareSeq(const void* left, const void* right) {
+    unsigned long long l = (*(_LE_Entity**)left)->seq;
+    unsigned long long r = (*(_LE_Entity**)right)->seq;
+    return (l > r) - (l < r);
+}
+
+static _LE_EntityListData* _LE_BroadphaseList(_LE_EntityListData* data, int source) {
+    return source < 0 ? data : LE_ENTITY_LIST_DATA(data->collisionLists[source]);
+}
+
+static unsigned long long _LE_BroadphaseNextSeq(_LE_EntityListData* data) {
+    unsigned long long nextSeq = data->nextSeq;
+    for (int i = 0; i < data->numCollisionLists; i++) {
+        nextSeq += LE_ENTITY_LIST_DATA(data->collisionLists[i])->nextSeq;
+    }
+    return nextSeq;
+}
+
+static void _LE_BroadphaseGather(_LE_Broadphase* broadphase, int source, unsigned long long from) {
+    _LE_EntityListData* data = broadphase->data;
+    _LE_Entity* entity = broadphase->entity;
+    data->numCandidates = broadphase->base;
+    broadphase->nextSeq = _LE_BroadphaseNextSeq(data);
+    broadphase->x1 = entity->posX - entity->width / 2;
+    broadphase->y1 = entity->posY - entity->height;
+    broadphase->x2 = entity->posX + entity->width / 2;
+    broadphase->y2 = entity->posY;
+    for (; source < data->numCollisionLists; source++) {
+        int start = data->numCandidates;
+        broadphase->from = from;
+        _LE_EntityGridQuery(_LE_BroadphaseList(data, source), broadphase->x1, broadphase->y1, broadphase->x2, broadphase->y2, _LE_BroadphaseVisitor, broadphase);
+        if (data->numCandidates - start > 1) qsort(data->candidates + start, data->numCandidates - start, sizeof(_LE_Entity*), _LE_CompareSeq);
+        from = 0;
+    }
+}
+
+static void _LE_BroadphaseRestart(_LE_Broadphase* broadphase, _LE_Entity* curr) {
+    _LE_EntityListData* data = broadphase->data;
+    _LE_EntityListData* list = LE_ENTITY_LIST_DATA(curr->parent);
+    int source = -1;
+    while (source < data->numCollisionLists && _LE_BroadphaseList(data, source) != list) source++;
+    _LE_BroadphaseGather(broadphase, source, curr->seq + 1);
+}
+
+static bool _LE_BroadphaseStale(_LE_Broadphase* broadphase) {
+    _LE_Entity* entity = broadphase->entity;
+    return _LE_BroadphaseNextSeq(broadphase->data) != broadphase->nextSeq
+        || entity->posX - entity->width / 2 != broadphase->x1
+        || entity->posY - entity->height    != broadphase->y1
+        || entity->posX + entity->width / 2 != broadphase->x2
+        || entity->posY                     != broadphase->y2;
+}
+
+#define LE_SWEEP_PENETRATION (1.f / 64)
+
+typedef struct {
+    _LE_Entity* entity;
+    bool vertical;
+    float from, to;
+    float front;
+    float delta;
+    float distance;
+} _LE_Sweep;
+
+static void _LE_SweepBox(_LE_Sweep* sweep, float x1, float y1, float x2, float y2) {
+    float from = sweep->vertical ? x1 : y1;
+    float to   = sweep->vertical ? x2 : y2;
+    if (!(sweep->to > from && to > sweep->from)) return;
+    float distance = sweep->delta > 0
+        ? (sweep->vertical ? y1 : x1) - sweep->front
+        : sweep->front - (sweep->vertical ? y2 : x2);
+    if (distance < 0 || distance >= sweep->distance) return;
+    sweep->distance = distance;
+}
+
+static bool _LE_SweepVisitor(_LE_Entity* curr, void* userdata) {
+    _LE_Sweep* sweep = userdata;
+    if (curr == sweep->entity || curr->deleted || !(curr->flags & LE_EntityFlags_SolidHitbox)) return true;
+    if (!LE_ENTITIES_INTERACT(curr, sweep->entity)) return true;
+    if (curr->platform == (LE_Entity*)sweep->entity) return true;
+    _LE_SweepBox(sweep, curr->posX - curr->width / 2, curr->posY - curr->height, curr->posX + curr->width / 2, curr->posY);
+    return true;
+}
+
+static float _LE_SweepCollision(LE_Entity* entity, bool vertical, float delta) {
+    if (delta == 0 || entity->flags & LE_EntityFlags_DisableCollision) return delta;
+    _LE_Entity* e = (_LE_Entity*)entity;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(e->parent);
+    _LE_Sweep sweep;
+    sweep.entity = e;
+    sweep.vertical = vertical;
+    sweep.delta = delta;
+    sweep.distance = fabsf(delta);
+    sweep.from  = vertical ? e->posX - e->width / 2 : e->posY - e->height;
+    sweep.to    = vertical ? e->posX + e->width / 2 : e->posY;
+    sweep.front = vertical ? (delta > 0 ? e->posY : e->posY - e->height) : (delta > 0 ? e->posX + e->width / 2 : e->posX - e->width / 2);
+    float x1 = e->posX - e->width / 2 + (!vertical && delta < 0 ? delta : 0);
+    float y1 = e->posY - e->height    + ( vertical && delta < 0 ? delta : 0);
+    float x2 = e->posX + e->width / 2 + (!vertical && delta > 0 ? delta : 0);
+    float y2 = e->posY                + ( vertical && delta > 0 ? delta : 0);
+    LE_Tilemap* tilemap = data->tilemap;
+    if (tilemap) {
+        int w, h;
+        LE_TilemapGetSize(tilemap, &w, &h);
+        int tfx = floorf(x1) < 0 ? 0 : floorf(x1);
+        int tfy = floorf(y1) < 0 ? 0 : floorf(y1);
+        int ttx = floorf(x2) >= w ? w - 1 : floorf(x2);
+        int tty = floorf(y2) >= h ? h - 1 : floorf(y2);
+        for (int y = tfy; y <= tty; y++) {
+            for (int x = tfx; x <= ttx; x++) {
+                LE_TileData* tile = LE_TilemapGetTileData(tilemap, x, y);
+                if (tile && LE_TileIsSolid(tile)) _LE_SweepBox(&sweep, x, y, x + 1, y + 1);
+            }
+        }
+    }
+    _LE_EntityGridQuery(data, x1, y1, x2, y2, _LE_SweepVisitor, &sweep);
+    for (int i = 0; i < data->numCollisionLists; i++) {
+        _LE_EntityGridQuery(LE_ENTITY_LIST_DATA(data->collisionLists[i]), x1, y1, x2, y2, _LE_SweepVisitor, &sweep);
+    }
+    if (sweep.distance >= fabsf(delta)) return delta;
+    float distance = sweep.distance + LE_SWEEP_PENETRATION;
+    if (distance > fabsf(delta)) distance = fabsf(delta);
+    return delta > 0 ? distance : -distance;
+}
+
+float LE_SweepCollisionX(LE_Entity* entity, float delta) {
+    return _LE_SweepCollision(entity, false, delta);
+}
+
+float LE_SweepCollisionY(LE_Entity* entity, float delta) {
+    return _LE_SweepCollision(entity, true, delta);
+}
+
+static void _LE_TileContact(LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity, int tileX, int tileY, LE_Direction direction) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(((_LE_Entity*)entity)->parent);
+    if (data->contactCache) _LE_RecordTileContact(data, (_LE_Entity*)entity, tile, tileX, tileY, direction);
+    else LE_TileCollisionEvent(tile, tilemap, entity, tileX, tileY, direction);
+}
+
+static void _LE_EntityContact(LE_Entity* entity, LE_Entity* collider) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(((_LE_Entity*)entity)->parent);
+    if (data->contactCache) _LE_RecordEntityContact(data, (_LE_Entity*)entity, (_LE_Entity*)collider);
+    else LE_EntityCollision(entity, collider);
+}
+
 #define COLLISION(AXIS)                                                                                                       \
 void CONCAT(LE_RunCollision, AXIS)(LE_Entity* entity) {                                                                       \
     if (entity->flags & LE_EntityFlags_DisableCollision) return;                                                              \
+    LE_PROFILE_BEGIN(tiles);                                                                                                  \
     LE_Tilemap* tilemap = LE_EntityGetTilemap(LE_EntityGetList(entity));                                                      \
     int w = 0;                                                                                                                \
     int h = 0;                                                                                                                \
@@ -49,10 +259,10 @@ void CONCAT(LE_RunCollision, AXIS)(LE_Entity* entity) {
     float fy = entity->posY - entity->height;                                                                                 \
     float tx = entity->posX + entity->width / 2;                                                                              \
     float ty = entity->posY;                                                                                                  \
-    int tfx = fx - 1;                                                                                                         \
-    int tfy = fy - 1;                                                                                                         \
-    int ttx = tx + 1;                                                                                                         \
-    int tty = ty + 1;                                                                                                         \
+    int tfx = fminf(fmaxf(fx - 1, 0), w);                                                                                     \
+    int tfy = fminf(fmaxf(fy - 1, 0), h);                                                                                     \
+    int ttx = fminf(fmaxf(tx + 1, -1), w - 1);                                                                                \
+    int tty = fminf(fmaxf(ty + 1, -1), h - 1);                                                                                \
     bool collided = false;                                                                                                    \
     if (RUN(IS_Y, AXIS)) entity->flags &= ~LE_EntityFlags_OnGround;                                                           \
     for (int y = tfy; y <= tty; y++) {                                                                                        \
@@ -63,14 +273,14 @@ void CONCAT(LE_RunCollision, AXIS)(LE_Entity* entity) {
             bool side = RUN(entity->vel, AXIS) < 0;                                                                           \
             if (!LE_RectIntersectsRect(fx, fy, tx, ty, x, y, x + 1, y + 1)) continue;                                         \
             if (side) {                                                                                                       \
-                LE_TileCollisionEvent(tile, tilemap, entity, x, y, RUN(DIR_DR, AXIS));                                        \
+                _LE_TileContact(tile, tilemap, entity, x, y, RUN(DIR_DR, AXIS));                                              \
                 if (solid) {                                                                                                  \
                     LE_EntitySetProperty(entity, (LE_EntityProperty){ .asInt = RUN(DIR_DR, AXIS) }, "collision");             \
                     RUN(entity->pos, AXIS) = RUN(CORRECT_TILE_DR, AXIS);                                                      \
                 }                                                                                                             \
             }                                                                                                                 \
             else {                                                                                                            \
-                LE_TileCollisionEvent(tile, tilemap, entity, x, y, RUN(DIR_UL, AXIS));                                        \
+                _LE_TileContact(tile, tilemap, entity, x, y, RUN(DIR_UL, AXIS));                                              \
                 if (solid) {                                                                                                  \
                     LE_EntitySetProperty(entity, (LE_EntityProperty){ .asInt = RUN(DIR_UL, AXIS) }, "collision");             \
                     RUN(entity->pos, AXIS) = RUN(CORRECT_TILE_UL, AXIS);                                                      \
@@ -80,24 +290,26 @@ void CONCAT(LE_RunCollision, AXIS)(LE_Entity* entity) {
             if (solid) collided = true;                                                                                       \
         }                                                                                                                     \
     }                                                                                                                         \
+    LE_PROFILE_END_ENTITY(tiles, _LE_Zone_TileCollision, entity);                                                             \
+    LE_PROFILE_BEGIN(entities);                                                                                               \
     LE_EntitySetPlatform(entity, NULL);                                                                                       \
-    LE_EntityListIter* iter = LE_EntityListGetIter(LE_EntityGetList(entity));                                                 \
-    while (iter) {                                                                                                            \
-        LE_Entity* curr = LE_EntityListGet(iter);                                                                             \
-        if (curr == entity || LE_EntityIsDeleted(curr)) {                                                                     \
-            iter = LE_EntityListNext(iter);                                                                                   \
-            continue;                                                                                                         \
-        }                                                                                                                     \
+    _LE_Broadphase broadphase;                                                                                                \
+    broadphase.entity = (_LE_Entity*)entity;                                                                                  \
+    broadphase.data = LE_ENTITY_LIST_DATA(broadphase.entity->parent);                                                         \
+    broadphase.base = broadphase.data->numCandidates;                                                                         \
+    _LE_BroadphaseGather(&broadphase, -1, 0);                                                                                 \
+    for (int i = broadphase.base; i < broadphase.data->numCandidates; i++) {                                                  \
+        LE_Entity* curr = (LE_Entity*)broadphase.data->candidates[i];                                                         \
+        if (LE_EntityIsDeleted(curr)) continue;                                                                               \
+        if (!LE_ENTITIES_INTERACT(broadphase.data->candidates[i], broadphase.entity)) continue;                               \
+        LE_PROFILE_COUNT(_LE_Counter_PairTests, 1);                                                                           \
         if (!LE_RectIntersectsRect(                                                                                           \
             entity->posX - entity->width / 2, entity->posY - entity->height, entity->posX + entity->width / 2, entity->posY,  \
                 curr->posX -   curr->width / 2,   curr->posY -   curr->height,   curr->posX +   curr->width / 2,   curr->posY \
-        )) {                                                                                                                  \
-            iter = LE_EntityListNext(iter);                                                                                   \
-            continue;                                                                                                         \
-        }                                                                                                                     \
+        )) continue;                                                                                                          \
         bool solid = curr->flags & LE_EntityFlags_SolidHitbox && LE_EntityGetPlatform(curr) != entity;                        \
         bool side = RUN(entity->vel, AXIS) < 0;                                                                               \
-        LE_EntityCollision(curr, entity);                                                                                     \
+        _LE_EntityContact(curr, entity);                                                                                      \
         if (solid) {                                                                                                          \
             if (side) {                                                                                                       \
                 LE_EntitySetProperty(entity, (LE_EntityProperty){ .asInt = RUN(DIR_DR, AXIS) }, "collision");                 \
@@ -113,9 +325,14 @@ void CONCAT(LE_RunCollision, AXIS)(LE_Entity* entity) {
             }                                                                                                                 \
             collided = true;                                                                                                  \
         }                                                                                                                     \
-        iter = LE_EntityListNext(iter);                                                                                       \
+        if (_LE_BroadphaseStale(&broadphase)) {                                                                               \
+            _LE_BroadphaseRestart(&broadphase, (_LE_Entity*)curr);                                                            \
+            i = broadphase.base - 1;                                                                                          \
+        }                                                                                                                     \
     }                                                                                                                         \
+    broadphase.data->numCandidates = broadphase.base;                                                                         \
     if (collided) RUN(entity->vel, AXIS) = 0;                                                                                 \
+    LE_PROFILE_END_ENTITY(entities, _LE_Zone_EntityCollision, entity);                                                        \
 }
 
 COLLISION(X)
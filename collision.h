@@ -3,6 +3,17 @@
 
 #include "lunarengine.h"
 
+bool LE_RectIntersectsRect(
+    float x1a, float y1a, float x2a, float y2a,
+    float x1b, float y1b, float x2b, float y2b
+);
+bool LE_RayIntersectsRect(
+    float x, float y, float dirX, float dirY, float maxDistance,
+    float x1, float y1, float x2, float y2,
+    float* distance, LE_Direction* direction
+);
+float LE_SweepCollisionX(LE_Entity* entity, float delta);
+float LE_SweepCollisionY(LE_Entity* entity, float delta);
 void LE_RunCollisionX(LE_Entity* entity);
 void LE_RunCollisionY(LE_Entity* entity);
 
@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity.h"
+#include "lunarengine.h"
+#include "memory.h"
+
+static unsigned int _LE_ContactHash(_LE_Contact* contact) {
+    unsigned int hash = contact->entity * 2654435761u;
+    hash ^= contact->collider * 40503u + (hash << 6) + (hash >> 2);
+    if (contact->tile) hash ^= ((unsigned int)contact->tileX * 73856093u) ^ ((unsigned int)contact->tileY * 19349663u);
+    return hash;
+}
+
+static bool _LE_ContactEquals(_LE_Contact* a, _LE_Contact* b) {
+    return a->entity == b->entity && a->collider == b->collider && a->colliderList == b->colliderList && a->tile == b->tile && a->tileX == b->tileX && a->tileY == b->tileY;
+}
+
+void _LE_RebuildContactIndex(_LE_EntityListData* data) {
+    int capacity = 16;
+    while (capacity < (data->numContacts + 1) * 2) capacity *= 2;
+    if (capacity != data->contactIndexCapacity) {
+        data->contactIndex = _LE_Realloc(data->contactIndex, sizeof(int) * capacity, LE_MemoryTag_Collision);
+        data->contactIndexCapacity = capacity;
+    }
+    memset(data->contactIndex, 0xFF, sizeof(int) * capacity);
+    unsigned int mask = capacity - 1;
+    for (int i = 0; i < data->numContacts; i++) {
+        unsigned int slot = _LE_ContactHash(&data->contacts[i]) & mask;
+        while (data->contactIndex[slot] >= 0) slot = (slot + 1) & mask;
+        data->contactIndex[slot] = i;
+    }
+}
+
+static void _LE_RecordContact(_LE_EntityListData* data, _LE_Contact contact) {
+    if ((data->numContacts + 1) * 2 > data->contactIndexCapacity) _LE_RebuildContactIndex(data);
+    unsigned int mask = data->contactIndexCapacity - 1;
+    unsigned int slot = _LE_ContactHash(&contact) & mask;
+    while (data->contactIndex[slot] >= 0) {
+        _LE_Contact* curr = &data->contacts[data->contactIndex[slot]];
+        if (_LE_ContactEquals(curr, &contact)) {
+            curr->stamp = data->contactStamp;
+            curr->direction = contact.direction;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    if (data->numContacts == data->contactCapacity) {
+        data->contactCapacity = data->contactCapacity ? data->contactCapacity * 2 : 64;
+        data->contacts = _LE_Realloc(data->contacts, sizeof(_LE_Contact) * data->contactCapacity, LE_MemoryTag_Collision);
+    }
+    contact.stamp = data->contactStamp;
+    contact.phase = LE_ContactPhase_Begin;
+    data->contactIndex[slot] = data->numContacts;
+    data->contacts[data->numContacts++] = contact;
+}
+
+void _LE_RecordEntityContact(_LE_EntityListData* data, _LE_Entity* entity, _LE_Entity* collider) {
+    LE_EntityList* colliderList = LE_EntityGetList((LE_Entity*)collider);
+    if (LE_ENTITY_LIST_DATA(colliderList) == data) colliderList = NULL;
+    _LE_RecordContact(data, (_LE_Contact){ .entity = entity->handle, .collider = collider->handle, .colliderList = colliderList });
+}
+
+void _LE_RecordTileContact(_LE_EntityListData* data, _LE_Entity* entity, LE_TileData* tile, int tileX, int tileY, LE_Direction direction) {
+    _LE_RecordContact(data, (_LE_Contact){ .entity = entity->handle, .tile = tile, .tileX = tileX, .tileY = tileY, .direction = direction });
+}
+
+static void _LE_ContactEvent(LE_EntityList* list, _LE_EntityListData* data, _LE_Contact* contact) {
+    LE_Entity* entity = LE_EntityFromHandle(list, contact->entity);
+    if (!entity) return;
+    if (contact->tile) {
+        LE_TileContactEvent(contact->tile, data->tilemap, entity, contact->tileX, contact->tileY, contact->direction, contact->phase);
+        return;
+    }
+    LE_Entity* collider = LE_EntityFromHandle(contact->colliderList ? contact->colliderList : list, contact->collider);
+    if (!collider) return;
+    _LE_CallbackArray* callbacks = &((_LE_Entity*)entity)->builder->contactCallbacks;
+    for (int j = 0; j < callbacks->count; j++) {
+        ((EntityContactCallback)callbacks->callbacks[j])(entity, collider, contact->phase);
+    }
+}
+
+void _LE_DispatchContacts(LE_EntityList* list) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (data->numContacts > data->contactEventCapacity) {
+        data->contactEventCapacity = data->contactCapacity;
+        data->contactEvents = _LE_Realloc(data->contactEvents, sizeof(_LE_Contact) * data->contactEventCapacity, LE_MemoryTag_Collision);
+    }
+    int numEvents = 0;
+    int numContacts = 0;
+    for (int i = 0; i < data->numContacts; i++) {
+        _LE_Contact* contact = &data->contacts[i];
+        if (contact->stamp != data->contactStamp) contact->phase = LE_ContactPhase_End;
+        data->contactEvents[numEvents++] = *contact;
+        if (contact->phase == LE_ContactPhase_End) continue;
+        contact->phase = LE_ContactPhase_Persist;
+        data->contacts[numContacts++] = *contact;
+    }
+    data->numContacts = numContacts;
+    data->contactStamp++;
+    _LE_RebuildContactIndex(data);
+    for (int i = 0; i < numEvents; i++) _LE_ContactEvent(list, data, &data->contactEvents[i]);
+}
+
+static bool _LE_ContactInvolves(_LE_Contact* contact, unsigned int handle, LE_EntityList* colliderList, bool owner) {
+    if (owner && contact->entity == handle) return true;
+    return !contact->tile && contact->colliderList == colliderList && contact->collider == handle;
+}
+
+static void _LE_EndContacts(LE_EntityList* list, unsigned int handle, LE_EntityList* colliderList, bool owner) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    int numEnded = 0;
+    for (int i = 0; i < data->numContacts; i++) {
+        if (_LE_ContactInvolves(&data->contacts[i], handle, colliderList, owner)) numEnded++;
+    }
+    if (numEnded == 0) return;
+    _LE_Contact* ended = _LE_Malloc(sizeof(_LE_Contact) * numEnded, LE_MemoryTag_Collision);
+    int numContacts = 0;
+    numEnded = 0;
+    for (int i = 0; i < data->numContacts; i++) {
+        _LE_Contact* contact = &data->contacts[i];
+        if (!_LE_ContactInvolves(contact, handle, colliderList, owner)) data->contacts[numContacts++] = *contact;
+        else if (contact->phase != LE_ContactPhase_Begin) {
+            ended[numEnded] = *contact;
+            ended[numEnded++].phase = LE_ContactPhase_End;
+        }
+    }
+    data->numContacts = numContacts;
+    _LE_RebuildContactIndex(data);
+    for (int i = 0; i < numEnded; i++) _LE_ContactEvent(list, data, &ended[i]);
+    _LE_Free(ended);
+}
+
+void _LE_EndEntityContacts(_LE_Entity* entity) {
+    LE_EntityList* list = LE_EntityGetList((LE_Entity*)entity);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_EndContacts(list, entity->handle, NULL, true);
+    for (int i = 0; i < data->numCollisionLists; i++) _LE_EndContacts(data->collisionLists[i], entity->handle, list, false);
+}
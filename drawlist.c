@@ -1,65 +1,358 @@
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include "linked_list.h"
+#include "drawlist.h"
 #include "lunarengine.h"
+#include "memory.h"
+#include "profile.h"
 
-typedef struct {
-    void* texture;
-    float dstX, dstY, dstW, dstH;
-    int   srcX, srcY, srcW, srcH;
-    unsigned int color;
-} LE_DrawListEntry;
+#define LE_DRAW_FIXED_SCALE 16
 
-typedef DEFINE_LIST(LE_DrawListEntry) _LE_DrawList;
+static const size_t entrySizes[] = {
+    [LE_DrawListFormat_Full]      = sizeof(LE_DrawListEntry),
+    [LE_DrawListFormat_Packed]    = sizeof(_LE_PackedEntry),
+    [LE_DrawListFormat_Quantized] = sizeof(_LE_QuantizedEntry),
+};
 
 LE_DrawList* LE_CreateDrawList() {
-    _LE_DrawList* dl = LE_LL_Create();
-    dl->value = malloc(sizeof(LE_DrawListEntry));
-    dl->value->color = 0xFFFFFFFF;
+    _LE_DrawList* dl = _LE_Malloc(sizeof(_LE_DrawList), LE_MemoryTag_DrawList);
+    memset(dl, 0, sizeof(_LE_DrawList));
+    dl->color = 0xFFFFFFFF;
+    dl->colorMark = -1;
+    dl->format = LE_DrawListFormat_Full;
     return (LE_DrawList*)dl;
 }
 
-void LE_Render(LE_DrawList* dl, DrawListRenderer renderer) {
+static _LE_DrawSegment* _LE_DrawListPopSpare(_LE_DrawList* dl, LE_DrawListFormat format) {
+    _LE_DrawSegment* segment = dl->spare;
+    if (!segment) {
+        segment = _LE_Malloc(sizeof(_LE_DrawSegment), LE_MemoryTag_DrawList);
+        memset(segment, 0, sizeof(_LE_DrawSegment));
+    }
+    else {
+        dl->spare = segment->next;
+        segment->next = NULL;
+    }
+    segment->count = 0;
+    segment->format = format;
+    segment->capacity = segment->bytes / entrySizes[format];
+    segment->numTextures = 0;
+    segment->lastTexture = -1;
+    return segment;
+}
+
+static void _LE_DrawListValidate(_LE_DrawList* dl) {
+    if (!dl->transient || !dl->head || dl->generation == _LE_FrameGeneration()) return;
+    dl->head = dl->tail = NULL;
+    dl->size = 0;
+    dl->colorMark = -1;
+}
+
+static void _LE_DrawListLink(_LE_DrawList* dl, _LE_DrawSegment* head, _LE_DrawSegment* tail) {
+    if (dl->tail) dl->tail->next = head;
+    else dl->head = head;
+    dl->tail = tail;
+}
+
+void _LE_DrawListLendSegment(LE_DrawList* from, LE_DrawList* to) {
+    _LE_DrawList* src = (_LE_DrawList*)from;
+    _LE_DrawList* dst = (_LE_DrawList*)to;
+    if (!src->spare || dst->spare || dst->transient) return;
+    _LE_DrawSegment* segment = _LE_DrawListPopSpare(src, LE_DrawListFormat_Full);
+    segment->next = dst->spare;
+    dst->spare = segment;
+}
+
+void _LE_DrawListReturnSpares(LE_DrawList* from, LE_DrawList* to) {
+    _LE_DrawList* src = (_LE_DrawList*)from;
+    _LE_DrawList* dst = (_LE_DrawList*)to;
+    if (!src->spare) return;
+    _LE_DrawSegment* last = src->spare;
+    while (last->next) last = last->next;
+    last->next = dst->spare;
+    dst->spare = src->spare;
+    src->spare = NULL;
+}
+
+static void _LE_DrawSegmentGrow(_LE_DrawSegment* segment, int count) {
+    if (segment->count + count <= segment->capacity) return;
+    size_t size = entrySizes[segment->format];
+    int capacity = segment->capacity ? segment->capacity : 256;
+    while (segment->count + count > capacity) capacity *= 2;
+    segment->entries = _LE_Realloc(segment->entries, size * capacity, LE_MemoryTag_DrawList);
+    segment->bytes = size * capacity;
+    segment->capacity = capacity;
+}
+
+static _LE_DrawSegment* _LE_DrawListReserve(_LE_DrawList* dl, int count, LE_DrawListFormat format, bool split) {
+    _LE_DrawListValidate(dl);
+    _LE_DrawSegment* segment = dl->tail;
+    bool matches = segment && segment->format == format && !split;
+    if (matches && !dl->transient) {
+        _LE_DrawSegmentGrow(segment, count);
+        return segment;
+    }
+    if (matches && segment->count + count <= segment->capacity) return segment;
+    _LE_DrawSegment* next;
+    if (dl->transient) {
+        int capacity = segment && segment->format == format ? segment->capacity * 2 : 256;
+        while (capacity < count) capacity *= 2;
+        next = _LE_FrameAlloc(sizeof(_LE_DrawSegment) + entrySizes[format] * capacity);
+        if (!next) return NULL;
+        memset(next, 0, sizeof(_LE_DrawSegment));
+        next->entries = next + 1;
+        next->bytes = entrySizes[format] * capacity;
+        next->capacity = capacity;
+        next->format = format;
+        next->lastTexture = -1;
+        if (!dl->head) dl->generation = _LE_FrameGeneration();
+    }
+    else {
+        next = _LE_DrawListPopSpare(dl, format);
+        _LE_DrawSegmentGrow(next, count);
+    }
+    _LE_DrawListLink(dl, next, next);
+    return next;
+}
+
+static int _LE_DrawSegmentTexture(_LE_DrawList* dl, _LE_DrawSegment* segment, void* texture) {
+    if (segment->lastTexture >= 0 && segment->textures[segment->lastTexture] == texture) return segment->lastTexture;
+    for (int i = 0; i < segment->numTextures; i++) {
+        if (segment->textures[i] == texture) return segment->lastTexture = i;
+    }
+    if (segment->numTextures == LE_DRAW_SEGMENT_TEXTURES) return -1;
+    if (!segment->textures) {
+        size_t size = sizeof(void*) * LE_DRAW_SEGMENT_TEXTURES;
+        segment->textures = dl->transient ? _LE_FrameAlloc(size) : _LE_Malloc(size, LE_MemoryTag_DrawList);
+        if (!segment->textures) return -1;
+    }
+    segment->textures[segment->numTextures] = texture;
+    return segment->lastTexture = segment->numTextures++;
+}
+
+static bool _LE_DrawFixedExact(float v) {
+    float scaled = v * LE_DRAW_FIXED_SCALE;
+    return fabsf(scaled) <= 32767.f && scaled == (float)(short)scaled && !(scaled == 0 && signbit(scaled));
+}
+
+static bool _LE_DrawEntryFits(LE_DrawListFormat format, LE_DrawListEntry* e) {
+    if (format == LE_DrawListFormat_Full) return true;
+    if ((unsigned int)e->srcX > 0xFFFF || (unsigned int)e->srcY > 0xFFFF) return false;
+    if ((unsigned int)e->srcW > 0xFFFF || (unsigned int)e->srcH > 0xFFFF) return false;
+    if (format == LE_DrawListFormat_Packed) return true;
+    return _LE_DrawFixedExact(e->dstX) && _LE_DrawFixedExact(e->dstY) && _LE_DrawFixedExact(e->dstW) && _LE_DrawFixedExact(e->dstH);
+}
+
+static void _LE_DrawListPush(_LE_DrawList* dl, LE_DrawListEntry* e) {
+    LE_DrawListFormat format = _LE_DrawEntryFits(dl->format, e) ? dl->format : LE_DrawListFormat_Full;
+    _LE_DrawSegment* segment = _LE_DrawListReserve(dl, 1, format, false);
+    if (!segment) return;
+    int texture = 0;
+    if (format != LE_DrawListFormat_Full && (texture = _LE_DrawSegmentTexture(dl, segment, e->texture)) < 0) {
+        segment = _LE_DrawListReserve(dl, 1, format, true);
+        if (!segment || (texture = _LE_DrawSegmentTexture(dl, segment, e->texture)) < 0) return;
+    }
+    void* slot = (unsigned char*)segment->entries + entrySizes[format] * segment->count++;
+    if (format == LE_DrawListFormat_Packed) {
+        _LE_PackedEntry* p = slot;
+        p->dstX = e->dstX; p->dstY = e->dstY;
+        p->dstW = e->dstW; p->dstH = e->dstH;
+        p->srcX = e->srcX; p->srcY = e->srcY;
+        p->srcW = e->srcW; p->srcH = e->srcH;
+        p->color = e->color;
+        p->texture = texture;
+    }
+    else if (format == LE_DrawListFormat_Quantized) {
+        _LE_QuantizedEntry* q = slot;
+        q->dstX = e->dstX * LE_DRAW_FIXED_SCALE; q->dstY = e->dstY * LE_DRAW_FIXED_SCALE;
+        q->dstW = e->dstW * LE_DRAW_FIXED_SCALE; q->dstH = e->dstH * LE_DRAW_FIXED_SCALE;
+        q->srcX = e->srcX; q->srcY = e->srcY;
+        q->srcW = e->srcW; q->srcH = e->srcH;
+        q->color = e->color;
+        q->texture = texture;
+    }
+    else *(LE_DrawListEntry*)slot = *e;
+    dl->size++;
+}
+
+static void _LE_DrawSegmentGet(_LE_DrawSegment* segment, int i, LE_DrawListEntry* e) {
+    if (segment->format == LE_DrawListFormat_Packed) {
+        _LE_PackedEntry* p = (_LE_PackedEntry*)segment->entries + i;
+        e->texture = segment->textures[p->texture];
+        e->dstX = p->dstX; e->dstY = p->dstY;
+        e->dstW = p->dstW; e->dstH = p->dstH;
+        e->srcX = p->srcX; e->srcY = p->srcY;
+        e->srcW = p->srcW; e->srcH = p->srcH;
+        e->color = p->color;
+    }
+    else if (segment->format == LE_DrawListFormat_Quantized) {
+        _LE_QuantizedEntry* q = (_LE_QuantizedEntry*)segment->entries + i;
+        e->texture = segment->textures[q->texture];
+        e->dstX = q->dstX / (float)LE_DRAW_FIXED_SCALE; e->dstY = q->dstY / (float)LE_DRAW_FIXED_SCALE;
+        e->dstW = q->dstW / (float)LE_DRAW_FIXED_SCALE; e->dstH = q->dstH / (float)LE_DRAW_FIXED_SCALE;
+        e->srcX = q->srcX; e->srcY = q->srcY;
+        e->srcW = q->srcW; e->srcH = q->srcH;
+        e->color = q->color;
+    }
+    else *e = ((LE_DrawListEntry*)segment->entries)[i];
+}
+
+static unsigned int* _LE_DrawSegmentColor(_LE_DrawSegment* segment, int i) {
+    if (segment->format == LE_DrawListFormat_Packed) return &((_LE_PackedEntry*)segment->entries)[i].color;
+    if (segment->format == LE_DrawListFormat_Quantized) return &((_LE_QuantizedEntry*)segment->entries)[i].color;
+    return &((LE_DrawListEntry*)segment->entries)[i].color;
+}
+
+void _LE_DrawListSetStartColor(LE_DrawList* dl, unsigned int color) {
     _LE_DrawList* drawlist = (_LE_DrawList*)dl;
-    while (drawlist->next) {
-        drawlist = drawlist->next;
-        renderer(drawlist->value->texture,
-            drawlist->value->dstX, drawlist->value->dstY,
-            drawlist->value->dstW, drawlist->value->dstH,
-            drawlist->value->srcX, drawlist->value->srcY,
-            drawlist->value->srcW, drawlist->value->srcH,
-            drawlist->value->color
-        );
+    _LE_DrawListValidate(drawlist);
+    int remaining = drawlist->colorMark < 0 ? drawlist->size : drawlist->colorMark;
+    for (_LE_DrawSegment* segment = drawlist->head; segment && remaining > 0; segment = segment->next) {
+        for (int i = 0; i < segment->count && remaining > 0; i++, remaining--) {
+            *_LE_DrawSegmentColor(segment, i) = color;
+        }
+    }
+    if (drawlist->colorMark < 0) drawlist->color = color;
+}
+
+void _LE_DrawListCopy(LE_DrawList* dst, LE_DrawList* src, int start, int end) {
+    _LE_DrawList* to = (_LE_DrawList*)dst;
+    _LE_DrawListValidate((_LE_DrawList*)src);
+    if (end <= start) return;
+    int index = 0;
+    for (_LE_DrawSegment* curr = ((_LE_DrawList*)src)->head; curr && index < end; curr = curr->next) {
+        int from = start > index ? start - index : 0;
+        int to_ = end - index < curr->count ? end - index : curr->count;
+        if (from < to_ && curr->format == LE_DrawListFormat_Full && to->format == LE_DrawListFormat_Full) {
+            _LE_DrawSegment* segment = _LE_DrawListReserve(to, to_ - from, LE_DrawListFormat_Full, false);
+            if (!segment) return;
+            memcpy((LE_DrawListEntry*)segment->entries + segment->count, (LE_DrawListEntry*)curr->entries + from, sizeof(LE_DrawListEntry) * (to_ - from));
+            segment->count += to_ - from;
+            to->size += to_ - from;
+        }
+        else for (int i = from; i < to_; i++) {
+            LE_DrawListEntry e;
+            _LE_DrawSegmentGet(curr, i, &e);
+            _LE_DrawListPush(to, &e);
+        }
+        index += curr->count;
+    }
+}
+
+void LE_Render(LE_DrawList* dl, DrawListRenderer renderer) {
+    LE_PROFILE_BEGIN(render);
+    _LE_DrawListValidate((_LE_DrawList*)dl);
+    for (_LE_DrawSegment* segment = ((_LE_DrawList*)dl)->head; segment; segment = segment->next) {
+        if (segment->format != LE_DrawListFormat_Full) {
+            for (int i = 0; i < segment->count; i++) {
+                LE_DrawListEntry e;
+                _LE_DrawSegmentGet(segment, i, &e);
+                renderer(e.texture, e.dstX, e.dstY, e.dstW, e.dstH, e.srcX, e.srcY, e.srcW, e.srcH, e.color);
+            }
+            continue;
+        }
+        for (int i = 0; i < segment->count; i++) {
+            LE_DrawListEntry* e = (LE_DrawListEntry*)segment->entries + i;
+            renderer(e->texture,
+                e->dstX, e->dstY,
+                e->dstW, e->dstH,
+                e->srcX, e->srcY,
+                e->srcW, e->srcH,
+                e->color
+            );
+        }
     }
+    LE_PROFILE_END(render, _LE_Zone_Render);
 }
 
 void LE_DrawListAppend(LE_DrawList* dl, void* texture, float dstX, float dstY, float dstW, float dstH, int srcX, int srcY, int srcW, int srcH) {
-    LE_DrawListEntry* e = malloc(sizeof(LE_DrawListEntry));
-    e->texture = texture;
-    e->dstX = dstX; e->dstY = dstY;
-    e->dstW = dstW; e->dstH = dstH;
-    e->srcX = srcX; e->srcY = srcY;
-    e->srcW = srcW; e->srcH = srcH;
-    e->color = LE_DrawGetColor(dl);
-    LE_LL_Add(dl, e);
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    LE_DrawListEntry e = {
+        .texture = texture,
+        .dstX = dstX, .dstY = dstY,
+        .dstW = dstW, .dstH = dstH,
+        .srcX = srcX, .srcY = srcY,
+        .srcW = srcW, .srcH = srcH,
+        .color = drawlist->color,
+    };
+    _LE_DrawListPush(drawlist, &e);
+    LE_PROFILE_COUNT(_LE_Counter_QuadsEmitted, 1);
+}
+
+void LE_DrawListConcat(LE_DrawList* dl, LE_DrawList* other) {
+    _LE_DrawList* dst = (_LE_DrawList*)dl;
+    _LE_DrawList* src = (_LE_DrawList*)other;
+    _LE_DrawListValidate(dst);
+    _LE_DrawListValidate(src);
+    if (!src->head) return;
+    if (dst->transient != src->transient) {
+        _LE_DrawListCopy(dl, other, 0, src->size);
+        LE_ClearDrawList(other);
+        return;
+    }
+    if (!dst->head) dst->generation = src->generation;
+    _LE_DrawListLink(dst, src->head, src->tail);
+    dst->size += src->size;
+    src->head = src->tail = NULL;
+    src->size = 0;
 }
 
 void LE_DrawSetColor(LE_DrawList* dl, unsigned int rgba) {
-    ((_LE_DrawList*)dl)->frst->value->color = rgba;
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    _LE_DrawListValidate(drawlist);
+    if (drawlist->colorMark < 0) drawlist->colorMark = drawlist->size;
+    drawlist->color = rgba;
 }
 
 void LE_ClearDrawList(LE_DrawList* dl) {
-    LE_LL_DeepClear(dl, free);
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    if (drawlist->tail && !drawlist->transient) {
+        drawlist->tail->next = drawlist->spare;
+        drawlist->spare = drawlist->head;
+    }
+    drawlist->head = drawlist->tail = NULL;
+    drawlist->size = 0;
+    drawlist->colorMark = -1;
+}
+
+static void _LE_FreeSegments(_LE_DrawSegment* segment) {
+    while (segment) {
+        _LE_DrawSegment* next = segment->next;
+        _LE_Free(segment->entries);
+        _LE_Free(segment->textures);
+        _LE_Free(segment);
+        segment = next;
+    }
 }
 
 void LE_DestroyDrawList(LE_DrawList* dl) {
-    LE_LL_DeepFree(dl, free);
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    if (!drawlist->transient) _LE_FreeSegments(drawlist->head);
+    _LE_FreeSegments(drawlist->spare);
+    _LE_Free(drawlist);
+}
+
+void LE_DrawListSetTransient(LE_DrawList* dl, bool transient) {
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    if (drawlist->transient == transient) return;
+    LE_ClearDrawList(dl);
+    drawlist->transient = transient;
+}
+
+void LE_DrawListSetFormat(LE_DrawList* dl, LE_DrawListFormat format) {
+    ((_LE_DrawList*)dl)->format = format;
+}
+
+LE_DrawListFormat LE_DrawListGetFormat(LE_DrawList* dl) {
+    return ((_LE_DrawList*)dl)->format;
 }
 
 int LE_DrawListSize(LE_DrawList* dl) {
-    return LE_LL_Size(dl);
+    _LE_DrawListValidate((_LE_DrawList*)dl);
+    return ((_LE_DrawList*)dl)->size;
 }
 
 unsigned int LE_DrawGetColor(LE_DrawList* dl) {
-    return ((_LE_DrawList*)dl)->frst->value->color;
-}
\ No newline at end of file
+    return ((_LE_DrawList*)dl)->color;
+}
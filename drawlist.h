@@ -0,0 +1,59 @@
+#ifndef LUNAR_ENGINE_DRAWLIST_H
+#define LUNAR_ENGINE_DRAWLIST_H
+
+#include <stddef.h>
+
+#include "lunarengine.h"
+
+#define LE_DRAW_SEGMENT_TEXTURES 256
+
+typedef struct {
+    void* texture;
+    float dstX, dstY, dstW, dstH;
+    int   srcX, srcY, srcW, srcH;
+    unsigned int color;
+} LE_DrawListEntry;
+
+typedef struct {
+    float dstX, dstY, dstW, dstH;
+    unsigned short srcX, srcY, srcW, srcH;
+    unsigned int color;
+    unsigned short texture;
+} _LE_PackedEntry;
+
+typedef struct {
+    short dstX, dstY, dstW, dstH;
+    unsigned short srcX, srcY, srcW, srcH;
+    unsigned int color;
+    unsigned short texture;
+} _LE_QuantizedEntry;
+
+typedef struct _LE_DrawSegment {
+    void* entries;
+    int count, capacity;
+    size_t bytes;
+    LE_DrawListFormat format;
+    void** textures;
+    int numTextures;
+    int lastTexture;
+    struct _LE_DrawSegment* next;
+} _LE_DrawSegment;
+
+typedef struct {
+    _LE_DrawSegment* head;
+    _LE_DrawSegment* tail;
+    _LE_DrawSegment* spare;
+    int size;
+    int colorMark;
+    unsigned int color;
+    bool transient;
+    unsigned int generation;
+    LE_DrawListFormat format;
+} _LE_DrawList;
+
+void _LE_DrawListLendSegment(LE_DrawList* from, LE_DrawList* to);
+void _LE_DrawListReturnSpares(LE_DrawList* from, LE_DrawList* to);
+void _LE_DrawListSetStartColor(LE_DrawList* dl, unsigned int color);
+void _LE_DrawListCopy(LE_DrawList* dst, LE_DrawList* src, int start, int end);
+
+#endif
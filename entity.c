@@ -1,49 +1,83 @@
+#include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "collision.h"
+#include "entity.h"
+#include "jobs.h"
 #include "linked_list.h"
 #include "lunarengine.h"
+#include "memory.h"
+#include "profile.h"
+#include "record.h"
+#include "spatial.h"
+
+void _LE_CallbackArrayAdd(_LE_CallbackArray* array, void* callback) {
+    if (array->count == array->capacity) {
+        array->capacity = array->capacity ? array->capacity * 2 : 4;
+        array->callbacks = _LE_Realloc(array->callbacks, sizeof(void*) * array->capacity, LE_MemoryTag_Entity);
+    }
+    array->callbacks[array->count++] = callback;
+}
 
 typedef struct {
-    char* name;
-    LE_EntityProperty value;
-} _LE_EntityProperty;
+    void** items;
+    unsigned int count, capacity, live;
+    pthread_mutex_t lock;
+} _LE_Registry;
 
-typedef DEFINE_LIST(EntityTextureCallback) _LE_TexCallbackList;
-typedef DEFINE_LIST(EntityUpdateCallback) _LE_UpdateCallbackList;
-typedef DEFINE_LIST(EntityCollisionCallback) _LE_CollisionCallbackList;
-typedef DEFINE_LIST(_LE_EntityProperty) _LE_EntityPropList;
+static _LE_Registry builderRegistry = { .lock = PTHREAD_MUTEX_INITIALIZER };
+static _LE_Registry listRegistry = { .lock = PTHREAD_MUTEX_INITIALIZER };
 
-typedef struct {
-    _LE_TexCallbackList* textureCallbacks;
-    _LE_UpdateCallbackList* updateCallbacks;
-    _LE_CollisionCallbackList* collisionCallbacks;
-    _LE_EntityPropList* properties;
-    float width, height;
-    int defaultDrawPriority;
-    LE_EntityFlags flags;
-} _LE_EntityBuilder;
+static unsigned int _LE_RegistryAdd(_LE_Registry* registry, void* item) {
+    pthread_mutex_lock(&registry->lock);
+    if (registry->count == registry->capacity) {
+        registry->capacity = registry->capacity ? registry->capacity * 2 : 16;
+        registry->items = _LE_Realloc(registry->items, sizeof(void*) * registry->capacity, LE_MemoryTag_Entity);
+    }
+    registry->items[registry->count++] = item;
+    registry->live++;
+    unsigned int id = registry->count;
+    pthread_mutex_unlock(&registry->lock);
+    return id;
+}
 
-typedef struct {
-    float posX, posY;
-    float velX, velY;
-    float width, height;
-    int drawPriority;
-    LE_EntityFlags flags;
-    float prevPosX, prevPosY;
-    float lastDrawnX, lastDrawnY;
-    bool deleted;
-    LE_Entity* platform;
-    _LE_EntityPropList* properties;
-    _LE_TexCallbackList* textureCallbacks;
-    _LE_UpdateCallbackList* updateCallbacks;
-    _LE_CollisionCallbackList* collisionCallbacks;
-    LE_EntityList* parent;
-    LE_Tilemap* tilemap;
-} _LE_Entity;
-
-typedef DEFINE_LIST(_LE_Entity) _LE_EntityList;
+static void _LE_RegistryRemove(_LE_Registry* registry, unsigned int id) {
+    pthread_mutex_lock(&registry->lock);
+    if (id > 0 && id <= registry->count && registry->items[id - 1]) {
+        registry->items[id - 1] = NULL;
+        registry->live--;
+    }
+    if (registry->live == 0) {
+        _LE_Free(registry->items);
+        registry->items = NULL;
+        registry->count = registry->capacity = 0;
+    }
+    pthread_mutex_unlock(&registry->lock);
+}
+
+static void* _LE_RegistryGet(_LE_Registry* registry, unsigned int id) {
+    pthread_mutex_lock(&registry->lock);
+    void* item = id > 0 && id <= registry->count ? registry->items[id - 1] : NULL;
+    pthread_mutex_unlock(&registry->lock);
+    return item;
+}
+
+_LE_EntityBuilder* _LE_BuilderFromId(unsigned int id) {
+    return _LE_RegistryGet(&builderRegistry, id);
+}
+
+LE_EntityList* _LE_ListFromId(unsigned int id) {
+    return _LE_RegistryGet(&listRegistry, id);
+}
+
+_LE_EntityPropList* _LE_AppendProperty(_LE_EntityPropList* tail, LE_EntityProperty property, const char* name) {
+    _LE_EntityProperty* p = _LE_Malloc(sizeof(_LE_EntityProperty), LE_MemoryTag_Property);
+    p->name = _LE_Strdup(name, LE_MemoryTag_Property);
+    p->value = property;
+    return LE_LL_Add(tail, p);
+}
 
 void _LE_AddPropertyToList(_LE_EntityPropList* list, LE_EntityProperty property, const char* name) {
     _LE_EntityPropList* curr = list;
@@ -54,32 +88,107 @@ void _LE_AddPropertyToList(_LE_EntityPropList* list, LE_EntityProperty property,
             return;
         }
     }
-    _LE_EntityProperty* p = malloc(sizeof(_LE_EntityProperty));
-    p->name = strdup(name);
-    p->value = property;
-    LE_LL_Add(list, p);
+    _LE_AppendProperty(curr, property, name);
+}
+
+static void _LE_FreeProperty(void* ptr) {
+    _LE_EntityProperty* property = ptr;
+    _LE_Free(property->name);
+    _LE_Free(property);
+}
+
+static _LE_EntityPropList* _LE_ClonePropertyList(_LE_EntityPropList* list) {
+    _LE_EntityPropList* clone = LE_LL_Create();
+    _LE_EntityPropList* tail = clone;
+    for (_LE_EntityPropList* curr = list->next; curr; curr = curr->next) {
+        tail = _LE_AppendProperty(tail, curr->value->value, curr->value->name);
+    }
+    return clone;
+}
+
+static void _LE_ReleasePropertyBlock(_LE_PropertyBlock* block) {
+    if (!block || atomic_fetch_sub(&block->refcount, 1) != 1) return;
+    LE_LL_DeepFree(block->properties, _LE_FreeProperty);
+    _LE_Free(block);
+}
+
+static _LE_PropertyBlock* _LE_AcquirePropertyBlock(_LE_EntityBuilder* builder, int count) {
+    _LE_PropertyBlock* block = atomic_load(&builder->propertyBlock);
+    if (!block) {
+        _LE_PropertyBlock* expected = NULL;
+        block = _LE_Malloc(sizeof(_LE_PropertyBlock), LE_MemoryTag_Property);
+        atomic_init(&block->refcount, 1);
+        block->properties = _LE_ClonePropertyList(builder->properties);
+        if (!atomic_compare_exchange_strong(&builder->propertyBlock, &expected, block)) {
+            _LE_ReleasePropertyBlock(block);
+            block = expected;
+        }
+    }
+    atomic_fetch_add(&block->refcount, count);
+    return block;
+}
+
+void _LE_EntityOwnProperties(_LE_Entity* entity) {
+    if (!entity->sharedProperties) return;
+    entity->properties = _LE_ClonePropertyList(entity->sharedProperties->properties);
+    _LE_ReleasePropertyBlock(entity->sharedProperties);
+    entity->sharedProperties = NULL;
+}
+
+void _LE_EntityShareProperties(_LE_Entity* entity) {
+    _LE_PropertyBlock* block = _LE_AcquirePropertyBlock(entity->builder, 1);
+    _LE_EntityReleaseProperties(entity);
+    entity->sharedProperties = block;
+    entity->properties = block->properties;
+}
+
+void _LE_EntityReleaseProperties(_LE_Entity* entity) {
+    if (entity->sharedProperties) _LE_ReleasePropertyBlock(entity->sharedProperties);
+    else LE_LL_DeepFree(entity->properties, _LE_FreeProperty);
+    entity->sharedProperties = NULL;
+    entity->properties = NULL;
 }
 
 LE_EntityBuilder* LE_CreateEntityBuilder() {
-    _LE_EntityBuilder* builder = malloc(sizeof(_LE_EntityBuilder));
+    _LE_EntityBuilder* builder = _LE_Malloc(sizeof(_LE_EntityBuilder), LE_MemoryTag_Entity);
     memset(builder, 0, sizeof(_LE_EntityBuilder));
-    builder->textureCallbacks = LE_LL_Create();
-    builder->updateCallbacks = LE_LL_Create();
-    builder->collisionCallbacks = LE_LL_Create();
     builder->properties = LE_LL_Create();
+    builder->category = 1;
+    builder->mask = ~0u;
+    builder->id = _LE_RegistryAdd(&builderRegistry, builder);
     return (LE_EntityBuilder*)builder;
 }
 
 void LE_EntityBuilderAddTextureCallback(LE_EntityBuilder* builder, EntityTextureCallback callback) {
-    LE_LL_Add(((_LE_EntityBuilder*)builder)->textureCallbacks, callback);
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->textureCallbacks, callback);
 }
 
 void LE_EntityBuilderAddUpdateCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback) {
-    LE_LL_Add(((_LE_EntityBuilder*)builder)->updateCallbacks, callback);
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->updateCallbacks, callback);
+}
+
+void LE_EntityBuilderAddBatchUpdateCallback(LE_EntityBuilder* builder, EntityBatchUpdateCallback callback) {
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->batchUpdateCallbacks, callback);
+}
+
+void LE_EntityBuilderAddWakeCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback) {
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->wakeCallbacks, callback);
+}
+
+void LE_EntityBuilderAddSleepCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback) {
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->sleepCallbacks, callback);
+}
+
+void LE_EntityBuilderSetAlwaysActive(LE_EntityBuilder* builder, bool alwaysActive) {
+    ((_LE_EntityBuilder*)builder)->alwaysActive = alwaysActive;
 }
 
 void LE_EntityBuilderAddCollisionCallback(LE_EntityBuilder* builder, EntityCollisionCallback callback) {
-    LE_LL_Add(((_LE_EntityBuilder*)builder)->collisionCallbacks, callback);
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->collisionCallbacks, callback);
+}
+
+void LE_EntityBuilderAddContactCallback(LE_EntityBuilder* builder, EntityContactCallback callback) {
+    _LE_CallbackArrayAdd(&((_LE_EntityBuilder*)builder)->contactCallbacks, callback);
 }
 
 void LE_EntityBuilderSetHitboxSize(LE_EntityBuilder* builder, float width, float height) {
@@ -92,6 +201,12 @@ void LE_EntityBuilderSetFlags(LE_EntityBuilder* builder, LE_EntityFlags flags) {
     ((_LE_EntityBuilder*)builder)->flags = flags;
 }
 
+void LE_EntityBuilderSetCollisionLayer(LE_EntityBuilder* builder, unsigned int category, unsigned int mask) {
+    _LE_EntityBuilder* eb = (_LE_EntityBuilder*)builder;
+    eb->category = category;
+    eb->mask = mask;
+}
+
 void LE_EntityBuilderSetDrawPriority(LE_EntityBuilder* builder, int drawPriority) {
     ((_LE_EntityBuilder*)builder)->defaultDrawPriority = drawPriority;
 }
@@ -105,78 +220,301 @@ void LE_EntityBuilderClearFlags(LE_EntityBuilder* builder, LE_EntityFlags flags)
 }
 
 void LE_EntityBuilderSetProperty(LE_EntityBuilder* builder, LE_EntityProperty property, const char* name) {
-    _LE_AddPropertyToList(((_LE_EntityBuilder*)builder)->properties, property, name);
+    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+    _LE_AddPropertyToList(b->properties, property, name);
+    _LE_ReleasePropertyBlock(b->propertyBlock);
+    b->propertyBlock = NULL;
+}
+
+void LE_EntityBuilderSetName(LE_EntityBuilder* builder, const char* name) {
+    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+    _LE_Free(b->name);
+    b->name = name ? _LE_Strdup(name, LE_MemoryTag_Entity) : NULL;
+}
+
+const char* LE_EntityBuilderGetName(LE_EntityBuilder* builder) {
+    return ((_LE_EntityBuilder*)builder)->name;
+}
+
+void LE_EntityBuilderSetSpriteCache(LE_EntityBuilder* builder, bool enabled, const char* frameProperty) {
+    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+    _LE_Free(b->spriteKey);
+    b->spriteCache = enabled;
+    b->spriteKey = enabled && frameProperty ? _LE_Strdup(frameProperty, LE_MemoryTag_Entity) : NULL;
 }
 
 void LE_DestroyEntityBuilder(LE_EntityBuilder* builder) {
     _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
-    LE_LL_Free(b->textureCallbacks);
-    LE_LL_Free(b->updateCallbacks);
-    LE_LL_Free(b->collisionCallbacks);
-    LE_LL_DeepFree(b->properties, free);
-    free(builder);
+    _LE_RegistryRemove(&builderRegistry, b->id);
+    _LE_Free(b->name);
+    _LE_Free(b->spriteKey);
+    _LE_Free(b->textureCallbacks.callbacks);
+    _LE_Free(b->updateCallbacks.callbacks);
+    _LE_Free(b->batchUpdateCallbacks.callbacks);
+    _LE_Free(b->collisionCallbacks.callbacks);
+    _LE_Free(b->contactCallbacks.callbacks);
+    _LE_Free(b->wakeCallbacks.callbacks);
+    _LE_Free(b->sleepCallbacks.callbacks);
+    LE_LL_DeepFree(b->properties, _LE_FreeProperty);
+    _LE_ReleasePropertyBlock(b->propertyBlock);
+    _LE_Free(builder);
 }
 
 LE_EntityList* LE_CreateEntityList() {
     _LE_EntityList* el = LE_LL_Create();
-    el->value = malloc(sizeof(_LE_Entity));
+    el->value = _LE_Malloc(sizeof(_LE_Entity), LE_MemoryTag_Entity);
     el->value->parent = (LE_EntityList*)el;
-    el->value->tilemap = NULL;
+    el->value->listData = _LE_Malloc(sizeof(_LE_EntityListData), LE_MemoryTag_Entity);
+    memset(el->value->listData, 0, sizeof(_LE_EntityListData));
+    _LE_GridInit(&el->value->listData->grid, 4);
+    _LE_GridInit(&el->value->listData->staticGrid, 4);
+    el->value->listData->tail = el;
+    el->value->listData->id = _LE_RegistryAdd(&listRegistry, el);
     return (LE_EntityList*)el;
 }
 
-LE_Entity* LE_CreateEntity(LE_EntityList* list, LE_EntityBuilder* builder, float x, float y) {
-    _LE_Entity* entity = malloc(sizeof(_LE_Entity));
-    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+static _LE_Entity* _LE_NewEntity(_LE_EntityBuilder* b, _LE_PropertyBlock* properties, float x, float y) {
+    _LE_Entity* entity = _LE_Malloc(sizeof(_LE_Entity), LE_MemoryTag_Entity);
     entity->posX = x;
     entity->posY = y;
+    entity->prevPosX = x;
+    entity->prevPosY = y;
+    entity->lastDrawnX = entity->lastDrawnY = 0;
     entity->velX = 0;
     entity->velY = 0;
     entity->width = b->width;
     entity->height = b->height;
     entity->flags = b->flags;
+    entity->category = b->category;
+    entity->mask = b->mask;
     entity->deleted = false;
     entity->platform = NULL;
     entity->drawPriority = b->defaultDrawPriority;
-    entity->textureCallbacks = b->textureCallbacks;
-    entity->updateCallbacks = b->updateCallbacks;
-    entity->collisionCallbacks = b->collisionCallbacks;
-    entity->properties = LE_LL_Create();
-    entity->parent = LE_LL_Add(list, entity);
-    _LE_EntityPropList* curr = b->properties;
-    while (curr->next) {
-        curr = curr->next;
-        _LE_AddPropertyToList(entity->properties, curr->value->value, curr->value->name);
-    }
+    entity->builder = b;
+    entity->listData = NULL;
+    entity->dormant = false;
+    entity->spriteW = entity->spriteH = -1;
+    entity->spriteCached = false;
+    entity->recordVelX = entity->recordVelY = 0;
+    entity->syncStamp = 0;
+    entity->sharedProperties = properties;
+    entity->properties = properties->properties;
+    return entity;
+}
+
+LE_Entity* LE_CreateEntity(LE_EntityList* list, LE_EntityBuilder* builder, float x, float y) {
+    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+    _LE_Entity* entity = _LE_NewEntity(b, _LE_AcquirePropertyBlock(b, 1), x, y);
+    _LE_AttachEntity(entity, list);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (data->recording) _LE_RecordSpawn(data->recording, data->recordIndex, builder, x, y);
     return (LE_Entity*)entity;
 }
 
+void LE_CreateEntities(LE_EntityList* list, LE_EntityBuilder* builder, int count, const float* positions, LE_Entity** out) {
+    if (count <= 0) return;
+    _LE_EntityBuilder* b = (_LE_EntityBuilder*)builder;
+    _LE_PropertyBlock* properties = _LE_AcquirePropertyBlock(b, count);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    for (int i = 0; i < count; i++) {
+        _LE_Entity* entity = _LE_NewEntity(b, properties, positions[i * 2], positions[i * 2 + 1]);
+        _LE_AttachEntity(entity, list);
+        if (data->recording) _LE_RecordSpawn(data->recording, data->recordIndex, builder, positions[i * 2], positions[i * 2 + 1]);
+        if (out) out[i] = (LE_Entity*)entity;
+    }
+}
+
+static _Thread_local _LE_Entity* speculatingEntity = NULL;
+static _Thread_local _LE_SpeculativeEntity* speculatingState = NULL;
+
+static bool _LE_DeferOp(_LE_Entity* entity, _LE_DeferredOpType type, LE_EntityProperty* value, const char* name, float x, float y) {
+    if (entity != speculatingEntity) return false;
+    _LE_SpeculativeEntity* spec = speculatingState;
+    if (spec->numOps == spec->opCapacity) {
+        spec->opCapacity = spec->opCapacity ? spec->opCapacity * 2 : 4;
+        spec->ops = _LE_Realloc(spec->ops, sizeof(_LE_DeferredOp) * spec->opCapacity, LE_MemoryTag_Entity);
+    }
+    _LE_DeferredOp* op = &spec->ops[spec->numOps++];
+    op->type = type;
+    if (value) op->value = *value;
+    op->name = name ? _LE_Strdup(name, LE_MemoryTag_Entity) : NULL;
+    op->x = x;
+    op->y = y;
+    return true;
+}
+
+void _LE_SyncAddHandle(_LE_SnapshotSync* sync, unsigned int handle) {
+    if (sync->numHandles == sync->handleCapacity) {
+        sync->handleCapacity = sync->handleCapacity ? sync->handleCapacity * 2 : 64;
+        sync->handles = _LE_Realloc(sync->handles, sizeof(unsigned int) * sync->handleCapacity, LE_MemoryTag_Snapshot);
+    }
+    sync->handles[sync->numHandles++] = handle;
+}
+
+void _LE_EntityTouch(_LE_Entity* entity) {
+    if (!entity->parent || entity == speculatingEntity) return;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_SnapshotSync* sync = &data->sync;
+    if (!sync->generation || entity->syncStamp == sync->stamp) return;
+    if (sync->numHandles > data->numHandles * 2 + 1024) {
+        sync->generation = 0;
+        return;
+    }
+    entity->syncStamp = sync->stamp;
+    _LE_SyncAddHandle(sync, entity->handle);
+}
+
+static void _LE_EntityMoved(_LE_Entity* entity, float x, float y) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_EntityTouch(entity);
+    _LE_EntityGridUpdate(data, entity, true);
+    data->idleStep = fmaxf(data->idleStep, _LE_EntityStep(entity));
+    data->version++;
+    if (data->recording) _LE_RecordEntity(data->recording, _LE_RecordEvent_Position, data->recordIndex, entity->handle, x, y);
+}
+
+static void _LE_EntityPropertyChanged(_LE_Entity* entity, LE_EntityProperty* property, const char* name) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_EntityTouch(entity);
+    data->version++;
+    if (data->recording) _LE_RecordProperty(data->recording, data->recordIndex, entity->handle, property, name);
+}
+
+static void _LE_EntityQueueDelete(_LE_Entity* entity) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_EntityTouch(entity);
+    data->version++;
+    if (data->recording) _LE_RecordEntity(data->recording, _LE_RecordEvent_Delete, data->recordIndex, entity->handle, 0, 0);
+    entity->pendingIndex = data->numPendingDelete;
+    _LE_PushEntity(&data->pendingDelete, &data->numPendingDelete, &data->pendingDeleteCapacity, entity);
+}
+
+static void _LE_ApplyDeferredOps(_LE_Entity* entity, _LE_SpeculativeEntity* spec) {
+    for (int i = 0; i < spec->numOps; i++) {
+        _LE_DeferredOp* op = &spec->ops[i];
+        switch (op->type) {
+            case _LE_DeferredOp_Property:
+                _LE_EntityPropertyChanged(entity, &op->value, op->name);
+                break;
+            case _LE_DeferredOp_DelProperty:
+                _LE_EntityPropertyChanged(entity, NULL, op->name);
+                break;
+            case _LE_DeferredOp_Delete:
+                _LE_EntityQueueDelete(entity);
+                break;
+            case _LE_DeferredOp_Position:
+                _LE_EntityMoved(entity, op->x, op->y);
+                break;
+        }
+        _LE_Free(op->name);
+    }
+    spec->numOps = 0;
+}
+
+void LE_EntitySetPosition(LE_Entity* entity, float x, float y) {
+    _LE_Entity* e = (_LE_Entity*)entity;
+    e->posX = x;
+    e->posY = y;
+    if (!_LE_DeferOp(e, _LE_DeferredOp_Position, NULL, NULL, x, y)) _LE_EntityMoved(e, x, y);
+}
+
 LE_Entity* LE_EntityGetPlatform(LE_Entity* entity) {
     return ((_LE_Entity*)entity)->platform;
 }
 
+void LE_EntitySetCollisionLayer(LE_Entity* entity, unsigned int category, unsigned int mask) {
+    _LE_Entity* e = (_LE_Entity*)entity;
+    e->category = category;
+    e->mask = mask;
+    _LE_EntityTouch(e);
+}
+
+void LE_EntityGetCollisionLayer(LE_Entity* entity, unsigned int* category, unsigned int* mask) {
+    _LE_Entity* e = (_LE_Entity*)entity;
+    if (category) *category = e->category;
+    if (mask) *mask = e->mask;
+}
+
 void LE_EntitySetPlatform(LE_Entity* entity, LE_Entity* platform) {
     ((_LE_Entity*)entity)->platform = platform;
+    _LE_EntityTouch((_LE_Entity*)entity);
 }
 
 void LE_EntityAssignTilemap(LE_EntityList* list, LE_Tilemap* tilemap) {
-    ((_LE_EntityList*)list)->value->tilemap = tilemap;
+    ((_LE_EntityList*)list)->value->listData->tilemap = tilemap;
+}
+
+int _LE_AddActivationRegion(LE_EntityList* list, _LE_ActivationRegion region) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    int index = 0;
+    while (index < data->regionCapacity && data->regions[index].used) index++;
+    if (index == data->regionCapacity) {
+        data->regionCapacity = data->regionCapacity ? data->regionCapacity * 2 : 4;
+        data->regions = _LE_Realloc(data->regions, sizeof(_LE_ActivationRegion) * data->regionCapacity, LE_MemoryTag_Entity);
+        memset(data->regions + index, 0, sizeof(_LE_ActivationRegion) * (data->regionCapacity - index));
+    }
+    region.used = true;
+    data->regions[index] = region;
+    data->numRegions++;
+    return index;
+}
+
+int LE_EntityListAddActivationRect(LE_EntityList* list, float x, float y, float w, float h) {
+    return _LE_AddActivationRegion(list, (_LE_ActivationRegion){ .x = x, .y = y, .w = w, .h = h });
+}
+
+int LE_EntityListAddCameraActivation(LE_EntityList* list, LE_LayerList* layers, float w, float h) {
+    return _LE_AddActivationRegion(list, (_LE_ActivationRegion){ .camera = true, .layers = layers, .w = w, .h = h });
+}
+
+void LE_EntityListSetActivationRect(LE_EntityList* list, int region, float x, float y, float w, float h) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (region < 0 || region >= data->regionCapacity || !data->regions[region].used) return;
+    data->regions[region].x = x;
+    data->regions[region].y = y;
+    data->regions[region].w = w;
+    data->regions[region].h = h;
+}
+
+void LE_EntityListRemoveActivationRegion(LE_EntityList* list, int region) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (region < 0 || region >= data->regionCapacity || !data->regions[region].used) return;
+    data->regions[region].used = false;
+    data->numRegions--;
+}
+
+bool LE_EntityIsDormant(LE_Entity* entity) {
+    return ((_LE_Entity*)entity)->dormant;
+}
+
+static void _LE_EntitySpriteKeyChanged(_LE_Entity* entity, LE_EntityProperty* property, const char* name) {
+    if (!entity->spriteCached || !entity->builder->spriteKey || strcmp(entity->builder->spriteKey, name) != 0) return;
+    LE_EntityProperty prev;
+    if (property && LE_EntityGetProperty((LE_Entity*)entity, &prev, name) && memcmp(&prev, property, sizeof(LE_EntityProperty)) == 0) return;
+    entity->spriteCached = false;
 }
 
 void LE_EntitySetProperty(LE_Entity* entity, LE_EntityProperty property, const char* name) {
+    _LE_EntitySpriteKeyChanged((_LE_Entity*)entity, &property, name);
+    _LE_EntityOwnProperties((_LE_Entity*)entity);
     _LE_AddPropertyToList(((_LE_Entity*)entity)->properties, property, name);
+    if (!((_LE_Entity*)entity)->parent) return;
+    if (!_LE_DeferOp((_LE_Entity*)entity, _LE_DeferredOp_Property, &property, name, 0, 0)) _LE_EntityPropertyChanged((_LE_Entity*)entity, &property, name);
 }
 
 void LE_EntityDelProperty(LE_Entity* entity, const char* name) {
     if (LE_EntityIsDeleted(entity)) return;
+    _LE_EntitySpriteKeyChanged((_LE_Entity*)entity, NULL, name);
+    _LE_EntityOwnProperties((_LE_Entity*)entity);
     _LE_EntityPropList* prop = ((_LE_Entity*)entity)->properties;
     while (prop->next) {
         prop = prop->next;
         _LE_EntityProperty* value = prop->value;
         if (strcmp(value->name, name) == 0) {
             LE_LL_Remove(prop->frst, value);
-            free(value->name);
-            free(value);
+            _LE_Free(value->name);
+            _LE_Free(value);
+            if (!_LE_DeferOp((_LE_Entity*)entity, _LE_DeferredOp_DelProperty, NULL, name, 0, 0)) _LE_EntityPropertyChanged((_LE_Entity*)entity, NULL, name);
             return;
         }
     }
@@ -209,50 +547,387 @@ const char* LE_EntityGetPropertyKey(LE_Entity* entity, int index) {
     return((_LE_EntityProperty*)LE_LL_Get(((_LE_Entity*)entity)->properties, index))->name;
 }
 
-void LE_EntityChangeLists(LE_Entity* entity, LE_EntityList* destlist) {
-    LE_LL_Remove(((_LE_Entity*)entity)->parent, entity);
-    LE_LL_Add(destlist, entity);
-    ((_LE_Entity*)entity)->parent = destlist;
+void LE_EntityCollision(LE_Entity* entity, LE_Entity* collider) {
+    _LE_EntityBuilder* b = ((_LE_Entity*)entity)->builder;
+    if (!b) return;
+    EntityCollisionCallback* callbacks = (EntityCollisionCallback*)b->collisionCallbacks.callbacks;
+    for (int i = 0; i < b->collisionCallbacks.count; i++) {
+        callbacks[i](entity, collider);
+    }
 }
 
-void LE_EntityCollision(LE_Entity* entity, LE_Entity* collider) {
-    _LE_CollisionCallbackList* collision = ((_LE_Entity*)entity)->collisionCallbacks;
-    if (!collision) return;
-    while (collision->next) {
-        collision = collision->next;
-        ((EntityCollisionCallback)collision->value)(entity, collider);
+void _LE_PushEntity(_LE_Entity*** array, int* count, int* capacity, _LE_Entity* entity) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 64;
+        *array = _LE_Realloc(*array, sizeof(_LE_Entity*) * *capacity, LE_MemoryTag_Entity);
+    }
+    (*array)[(*count)++] = entity;
+}
+
+void _LE_RunBatchUpdates(_LE_EntityListData* data) {
+    int numBuilders = 0, count = 0;
+    for (int i = 0; i < data->numActive; i++) {
+        _LE_Entity* entity = data->active[i];
+        if (!entity || entity->deleted || entity->builder->batchUpdateCallbacks.count == 0) continue;
+        int index = numBuilders - 1;
+        while (index >= 0 && data->batchBuilders[index] != entity->builder) index--;
+        if (index < 0) {
+            if (numBuilders + 1 >= data->batchBuilderCapacity) {
+                data->batchBuilderCapacity = data->batchBuilderCapacity ? data->batchBuilderCapacity * 2 : 8;
+                data->batchBuilders = _LE_Realloc(data->batchBuilders, sizeof(_LE_EntityBuilder*) * data->batchBuilderCapacity, LE_MemoryTag_Entity);
+                data->batchOffsets = _LE_Realloc(data->batchOffsets, sizeof(int) * data->batchBuilderCapacity, LE_MemoryTag_Entity);
+            }
+            data->batchBuilders[numBuilders] = entity->builder;
+            data->batchOffsets[numBuilders + 1] = 0;
+            index = numBuilders++;
+        }
+        data->batchOffsets[index + 1]++;
+        count++;
+    }
+    if (count == 0) return;
+    _LE_EntityBuilder** builders = data->batchBuilders;
+    int* offsets = data->batchOffsets;
+    if (count > data->batchCapacity) {
+        data->batchCapacity = count;
+        data->batch = _LE_Realloc(data->batch, sizeof(_LE_Entity*) * count, LE_MemoryTag_Entity);
+    }
+    offsets[0] = 0;
+    for (int i = 1; i <= numBuilders; i++) offsets[i] += offsets[i - 1];
+    for (int i = 0; i < data->numActive; i++) {
+        _LE_Entity* entity = data->active[i];
+        if (!entity || entity->deleted || entity->builder->batchUpdateCallbacks.count == 0) continue;
+        int index = 0;
+        while (builders[index] != entity->builder) index++;
+        data->batch[offsets[index]++] = entity;
+    }
+    int start = 0;
+    LE_PROFILE_BEGIN(batch);
+    for (int i = 0; i < numBuilders; i++) {
+        EntityBatchUpdateCallback* callbacks = (EntityBatchUpdateCallback*)builders[i]->batchUpdateCallbacks.callbacks;
+        for (int j = 0; j < builders[i]->batchUpdateCallbacks.count; j++) {
+            callbacks[j]((LE_Entity**)data->batch + start, offsets[i] - start);
+        }
+        start = offsets[i];
+    }
+    LE_PROFILE_END(batch, _LE_Zone_UpdateCallbacks);
+}
+
+void _LE_RunCallbacks(_LE_CallbackArray* callbacks, _LE_Entity* entity) {
+    for (int i = 0; i < callbacks->count; i++) {
+        ((EntityUpdateCallback)callbacks->callbacks[i])((LE_Entity*)entity);
+    }
+}
+
+typedef struct {
+    _LE_EntityListData* data;
+    float x1, y1, x2, y2;
+} _LE_ActivationQuery;
+
+bool _LE_ActivateEntity(_LE_Entity* entity, void* userdata) {
+    _LE_ActivationQuery* query = userdata;
+    _LE_EntityListData* data = query->data;
+    if (entity->deleted || entity->activeStamp == data->activeStamp) return true;
+    if (!LE_RectIntersectsRect(
+        entity->posX - entity->width / 2, entity->posY - entity->height, entity->posX + entity->width / 2, entity->posY,
+        query->x1, query->y1, query->x2, query->y2
+    )) return true;
+    entity->activeStamp = data->activeStamp;
+    _LE_PushEntity(&data->nextActive, &data->numNextActive, &data->nextActiveCapacity, entity);
+    return true;
+}
+
+static int _LE_CompareSeq(const void* left, const void* right) {
+    unsigned long long l = (*(_LE_Entity**)left)->seq;
+    unsigned long long r = (*(_LE_Entity**)right)->seq;
+    return (l > r) - (l < r);
+}
+
+float _LE_EntityStep(_LE_Entity* entity) {
+    return fmaxf(fabsf(entity->posX - entity->prevPosX), fabsf(entity->posY - entity->prevPosY));
+}
+
+void _LE_CollectActiveEntities(_LE_EntityList* list) {
+    _LE_EntityListData* data = list->value->listData;
+    data->activeStamp++;
+    data->numNextActive = 0;
+    if (data->numRegions == 0) {
+        for (_LE_EntityList* curr = list->next; curr; curr = curr->next) {
+            if (curr->value->deleted) continue;
+            curr->value->activeStamp = data->activeStamp;
+            _LE_PushEntity(&data->nextActive, &data->numNextActive, &data->nextActiveCapacity, curr->value);
+        }
+    }
+    else {
+        int tileW = 1, tileH = 1;
+        if (data->tilemap && LE_TilemapGetTileset(data->tilemap)) LE_TilesetGetTileSize(LE_TilemapGetTileset(data->tilemap), &tileW, &tileH);
+        for (int i = 0; i < data->regionCapacity; i++) {
+            _LE_ActivationRegion* region = &data->regions[i];
+            if (!region->used) continue;
+            _LE_ActivationQuery query = { data, region->x, region->y, region->x + region->w, region->y + region->h };
+            if (region->camera) {
+                float camX, camY;
+                LE_GetCameraPos(region->layers, &camX, &camY);
+                query.x1 = camX / tileW - region->w / 2;
+                query.y1 = camY / tileH - region->h / 2;
+                query.x2 = query.x1 + region->w;
+                query.y2 = query.y1 + region->h;
+            }
+            _LE_EntityGridQuery(data, query.x1, query.y1, query.x2, query.y2, _LE_ActivateEntity, &query);
+        }
+        for (int i = 0; i < data->numAlwaysActive; i++) {
+            _LE_Entity* entity = data->alwaysActive[i];
+            if (entity->deleted || entity->activeStamp == data->activeStamp) continue;
+            entity->activeStamp = data->activeStamp;
+            _LE_PushEntity(&data->nextActive, &data->numNextActive, &data->nextActiveCapacity, entity);
+        }
+        qsort(data->nextActive, data->numNextActive, sizeof(_LE_Entity*), _LE_CompareSeq);
+    }
+    _LE_Entity** prev = data->active;
+    int numPrev = data->numActive;
+    int prevCapacity = data->activeCapacity;
+    data->active = data->nextActive;
+    data->numActive = data->numNextActive;
+    data->activeCapacity = data->nextActiveCapacity;
+    data->nextActive = prev;
+    data->numNextActive = numPrev;
+    data->nextActiveCapacity = prevCapacity;
+    for (int i = 0; i < numPrev; i++) {
+        if (prev[i]) prev[i]->activeIndex = -1;
+    }
+    for (int i = 0; i < data->numActive; i++) {
+        data->active[i]->activeIndex = i;
+    }
+    for (int i = 0; i < numPrev; i++) {
+        _LE_Entity* entity = prev[i];
+        if (!entity || entity->deleted || entity->dormant || entity->activeStamp == data->activeStamp) continue;
+        entity->dormant = true;
+        data->idleStep = fmaxf(data->idleStep, _LE_EntityStep(entity));
+        _LE_EntityTouch(entity);
+        _LE_RunCallbacks(&entity->builder->sleepCallbacks, entity);
+    }
+    data->numNextActive = 0;
+    for (int i = 0; i < data->numActive; i++) {
+        _LE_Entity* entity = data->active[i];
+        if (!entity || entity->deleted || !entity->dormant) continue;
+        entity->dormant = false;
+        _LE_EntityTouch(entity);
+        _LE_RunCallbacks(&entity->builder->wakeCallbacks, entity);
+    }
+}
+
+void _LE_RunUpdateCallbacks(_LE_Entity* entity) {
+    LE_PROFILE_BEGIN(update);
+    EntityUpdateCallback* update = (EntityUpdateCallback*)entity->builder->updateCallbacks.callbacks;
+    for (int i = 0; i < entity->builder->updateCallbacks.count; i++) {
+        update[i]((LE_Entity*)entity);
+    }
+    LE_PROFILE_END_ENTITY(update, _LE_Zone_UpdateCallbacks, entity);
+    LE_PROFILE_COUNT(_LE_Counter_EntitiesUpdated, 1);
+}
+
+void _LE_IntegrateEntity(_LE_Entity* entity, float delta_time) {
+    entity->prevPosX = entity->posX;
+    entity->prevPosY = entity->posY;
+    if (entity->flags & LE_EntityFlags_Static) return;
+    if (entity->flags & LE_EntityFlags_Kinematic) {
+        entity->posY += entity->velY * delta_time;
+        entity->posX += entity->velX * delta_time;
+    }
+    else if (entity->flags & LE_EntityFlags_Continuous) {
+        entity->posY += LE_SweepCollisionY((LE_Entity*)entity, entity->velY * delta_time);
+        LE_RunCollisionY((LE_Entity*)entity);
+        entity->posX += LE_SweepCollisionX((LE_Entity*)entity, entity->velX * delta_time);
+        LE_RunCollisionX((LE_Entity*)entity);
+    }
+    else {
+        entity->posY += entity->velY * delta_time;
+        LE_RunCollisionY((LE_Entity*)entity);
+        entity->posX += entity->velX * delta_time;
+        LE_RunCollisionX((LE_Entity*)entity);
+    }
+    _LE_EntityGridUpdate(LE_ENTITY_LIST_DATA(entity->parent), entity, false);
+}
+
+static void _LE_SaveCollisionState(_LE_Entity* entity, _LE_CollisionState* state) {
+    state->posX = entity->posX;
+    state->posY = entity->posY;
+    state->width = entity->width;
+    state->height = entity->height;
+    state->flags = entity->flags;
+    state->platform = entity->platform;
+    state->category = entity->category;
+    state->mask = entity->mask;
+    state->deleted = entity->deleted;
+}
+
+static void _LE_LoadCollisionState(_LE_Entity* entity, _LE_CollisionState* state) {
+    entity->posX = state->posX;
+    entity->posY = state->posY;
+    entity->width = state->width;
+    entity->height = state->height;
+    entity->flags = state->flags;
+    entity->platform = state->platform;
+    entity->category = state->category;
+    entity->mask = state->mask;
+    entity->deleted = state->deleted;
+}
+
+typedef struct {
+    _LE_EntityListData* data;
+    int start;
+} _LE_SpeculateJob;
+
+void _LE_RunThreadSafeCallbacks(void* userdata, int start, int end) {
+    _LE_SpeculateJob* job = userdata;
+    for (int i = job->start + start; i < job->start + end; i++) {
+        _LE_Entity* entity = job->data->active[i];
+        _LE_SpeculativeEntity* spec = &job->data->speculative[i];
+        if (!entity || entity->deleted) continue;
+        _LE_SaveCollisionState(entity, &spec->state);
+        if (!(entity->flags & LE_EntityFlags_ThreadSafe)) continue;
+        _LE_CollisionState before = spec->state;
+        speculatingEntity = entity;
+        speculatingState = spec;
+        _LE_RunUpdateCallbacks(entity);
+        speculatingEntity = NULL;
+        speculatingState = NULL;
+        _LE_SaveCollisionState(entity, &spec->state);
+        _LE_LoadCollisionState(entity, &before);
     }
 }
 
+static int _LE_SpeculationEnd(_LE_EntityListData* data, int start) {
+    int end = start;
+    while (end < data->numActive) {
+        _LE_Entity* entity = data->active[end];
+        if (entity && !(entity->flags & LE_EntityFlags_ThreadSafe) && entity->builder->updateCallbacks.count > 0) break;
+        end++;
+    }
+    return end;
+}
+
+static void _LE_SpeculateUpdates(_LE_EntityListData* data, int start, int end) {
+    if (end > data->speculativeCapacity) {
+        int capacity = data->speculativeCapacity;
+        data->speculativeCapacity = end * 2;
+        data->speculative = _LE_Realloc(data->speculative, sizeof(_LE_SpeculativeEntity) * data->speculativeCapacity, LE_MemoryTag_Entity);
+        memset(data->speculative + capacity, 0, sizeof(_LE_SpeculativeEntity) * (data->speculativeCapacity - capacity));
+    }
+    _LE_SpeculateJob job = { data, start };
+    _LE_JobsParallelFor(end - start, 64, _LE_RunThreadSafeCallbacks, &job);
+}
+
 void LE_UpdateEntities(LE_EntityList* entities, float delta_time) {
     _LE_EntityList* e = (_LE_EntityList*)entities;
-    _LE_EntityList* curr = e;
-    while (curr->next) {
-        curr = curr->next;
-        LE_UpdateEntity((LE_Entity*)curr->value, delta_time);
+    _LE_EntityListData* data = e->value->listData;
+    LE_PROFILE_BEGIN(update);
+    _LE_CollectActiveEntities(e);
+    if (data->numActive > 0) data->version++;
+    _LE_RunBatchUpdates(data);
+    bool parallel = data->parallel && data->contactCache && _LE_JobsThreadCount() > 0;
+    for (int start = 0; start < data->numActive;) {
+        int end = parallel ? _LE_SpeculationEnd(data, start) : data->numActive;
+        bool speculate = parallel && end - start >= LE_PARALLEL_MIN_ENTITIES;
+        if (speculate) _LE_SpeculateUpdates(data, start, end);
+        for (int i = start; i < end; i++) {
+            _LE_Entity* entity = data->active[i];
+            if (!entity) continue;
+            if (!speculate) LE_UpdateEntity((LE_Entity*)entity, delta_time);
+            else if (!entity->deleted) {
+                _LE_LoadCollisionState(entity, &data->speculative[i].state);
+                _LE_ApplyDeferredOps(entity, &data->speculative[i]);
+                _LE_IntegrateEntity(entity, delta_time);
+            }
+        }
+        if (end < data->numActive && data->active[end]) LE_UpdateEntity((LE_Entity*)data->active[end], delta_time);
+        start = end + 1;
+    }
+    data->maxStep = 0;
+    for (int i = 0; i < data->numActive; i++) {
+        _LE_Entity* entity = data->active[i];
+        if (!entity) continue;
+        _LE_EntityGridUpdate(data, entity, false);
+        _LE_EntityTouch(entity);
+        data->maxStep = fmaxf(data->maxStep, _LE_EntityStep(entity));
+        if (entity->drawPriority != entity->sortedPriority) data->drawOrderChanges++;
     }
-    curr = e->next;
-    while (curr) {
-        _LE_EntityList* next = curr->next;
-        if (curr->value->deleted) LE_DestroyEntity((LE_Entity*)curr->value);
-        curr = next;
+    if (data->contactCache) _LE_DispatchContacts(entities);
+    for (int i = 0; i < data->numPendingDelete; i++) {
+        if (data->pendingDelete[i]) LE_DestroyEntity((LE_Entity*)data->pendingDelete[i]);
     }
+    data->numPendingDelete = 0;
+    int numActive = 0;
+    for (int i = 0; i < data->numActive; i++) {
+        if (!data->active[i]) continue;
+        data->active[i]->activeIndex = numActive;
+        data->active[numActive++] = data->active[i];
+    }
+    data->numActive = numActive;
+    _LE_GridReclaim(&data->grid);
+    _LE_GridReclaim(&data->staticGrid);
+    LE_PROFILE_END(update, _LE_Zone_UpdateEntities);
 }
 
 void LE_UpdateEntity(LE_Entity* entity, float delta_time) {
     _LE_Entity* e = (_LE_Entity*)entity;
-    _LE_UpdateCallbackList* update = e->updateCallbacks;
     if (e->deleted) return;
-    while (update->next) {
-        update = update->next;
-        ((EntityUpdateCallback)update->value)(entity);
+    _LE_EntityTouch(e);
+    _LE_RunUpdateCallbacks(e);
+    _LE_IntegrateEntity(e, delta_time);
+}
+
+void LE_EntityListSetParallel(LE_EntityList* list, bool parallel) {
+    LE_ENTITY_LIST_DATA(list)->parallel = parallel;
+}
+
+void LE_EntityListSetContactCache(LE_EntityList* list, bool enabled) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    data->contactCache = enabled;
+    data->numContacts = 0;
+    _LE_RebuildContactIndex(data);
+}
+
+static void _LE_ListArrayAdd(LE_EntityList*** array, int* count, int* capacity, LE_EntityList* list) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 4;
+        *array = _LE_Realloc(*array, sizeof(LE_EntityList*) * *capacity, LE_MemoryTag_Collision);
+    }
+    (*array)[(*count)++] = list;
+}
+
+static void _LE_ListArrayRemove(LE_EntityList** array, int* count, LE_EntityList* list) {
+    for (int i = 0; i < *count; i++) {
+        if (array[i] != list) continue;
+        memmove(array + i, array + i + 1, sizeof(LE_EntityList*) * (*count - i - 1));
+        (*count)--;
+        return;
     }
-    e->prevPosX = e->posX;
-    e->prevPosY = e->posY;
-    e->posY += e->velY * delta_time;
-    LE_RunCollisionY(entity);
-    e->posX += e->velX * delta_time;
-    LE_RunCollisionX(entity);
+}
+
+void LE_EntityListAddCollisionList(LE_EntityList* list, LE_EntityList* other) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_EntityListData* target = LE_ENTITY_LIST_DATA(other);
+    if (target == data) return;
+    for (int i = 0; i < data->numCollisionLists; i++) {
+        if (data->collisionLists[i] == other) return;
+    }
+    _LE_ListArrayAdd(&data->collisionLists, &data->numCollisionLists, &data->collisionListCapacity, other);
+    _LE_ListArrayAdd(&target->colliderOf, &target->numColliderOf, &target->colliderOfCapacity, list);
+}
+
+void LE_EntityListRemoveCollisionList(LE_EntityList* list, LE_EntityList* other) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_EntityListData* target = LE_ENTITY_LIST_DATA(other);
+    _LE_ListArrayRemove(data->collisionLists, &data->numCollisionLists, other);
+    _LE_ListArrayRemove(target->colliderOf, &target->numColliderOf, list);
+    int numContacts = 0;
+    for (int i = 0; i < target->numContacts; i++) {
+        if (target->contacts[i].colliderList == list) continue;
+        target->contacts[numContacts++] = target->contacts[i];
+    }
+    if (numContacts == target->numContacts) return;
+    target->numContacts = numContacts;
+    _LE_RebuildContactIndex(target);
 }
 
 void LE_EntityGetPrevPosition(LE_Entity* entity, float* x, float* y) {
@@ -266,23 +941,34 @@ bool LE_EntityIsDeleted(LE_Entity* entity) {
 
 void LE_DrawEntity(LE_Entity* entity, float x, float y, float scaleW, float scaleH, LE_DrawList* dl) {
     _LE_Entity* e = (_LE_Entity*)entity;
-    _LE_TexCallbackList* tex = e->textureCallbacks;
-    void* texture = NULL;
-    float width, height;
-    int srcX, srcY, srcW, srcH;
+    _LE_SpriteState* s = &e->sprite;
     int absw, absh;
     if (e->deleted) return;
-    while (tex->next) {
-        tex = tex->next;
-        texture = ((EntityTextureCallback)tex->value)(entity, &width, &height, &srcX, &srcY, &srcW, &srcH);
-        if (texture) break;
-    }
-    if (!texture) return;
-    absw = width  * (width  < 0 ? -1 : 1);
-    absh = height * (height < 0 ? -1 : 1);
+    if (!e->spriteCached) {
+        EntityTextureCallback* tex = (EntityTextureCallback*)e->builder->textureCallbacks.callbacks;
+        s->texture = NULL;
+        for (int i = 0; i < e->builder->textureCallbacks.count; i++) {
+            s->texture = tex[i](entity, &s->width, &s->height, &s->srcX, &s->srcY, &s->srcW, &s->srcH);
+            if (s->texture) break;
+        }
+        e->spriteCached = e->builder->spriteCache;
+    }
+    if (!s->texture) return;
+    _LE_EntityTouch(e);
+    absw = s->width  * (s->width  < 0 ? -1 : 1);
+    absh = s->height * (s->height < 0 ? -1 : 1);
+    e->spriteW = absw;
+    e->spriteH = absh;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(e->parent);
+    if (absw > data->maxSpriteW) data->maxSpriteW = absw;
+    if (absh > data->maxSpriteH) data->maxSpriteH = absh;
     e->lastDrawnX = x - (absw * scaleW) / 2;
     e->lastDrawnY = y - (absh * scaleH);
-    LE_DrawListAppend(dl, texture, e->lastDrawnX, e->lastDrawnY, width * scaleW, height * scaleH, srcX, srcY, srcW, srcH);
+    LE_DrawListAppend(dl, s->texture, e->lastDrawnX, e->lastDrawnY, s->width * scaleW, s->height * scaleH, s->srcX, s->srcY, s->srcW, s->srcH);
+}
+
+void LE_EntityInvalidateSprite(LE_Entity* entity) {
+    ((_LE_Entity*)entity)->spriteCached = false;
 }
 
 void LE_EntityLastDrawnPos(LE_Entity* entity, float* x, float* y) {
@@ -292,24 +978,284 @@ void LE_EntityLastDrawnPos(LE_Entity* entity, float* x, float* y) {
 }
 
 void LE_DeleteEntity(LE_Entity* entity) {
-    ((_LE_Entity*)entity)->deleted = true;
+    _LE_Entity* e = (_LE_Entity*)entity;
+    if (e->deleted) return;
+    e->deleted = true;
+    if (!_LE_DeferOp(e, _LE_DeferredOp_Delete, NULL, NULL, 0, 0)) _LE_EntityQueueDelete(e);
+}
+
+static void _LE_HandleMapPlace(_LE_Entity** map, int capacity, _LE_Entity* entity) {
+    unsigned int mask = capacity - 1;
+    unsigned int i = (entity->handle * 2654435761u) & mask;
+    while (map[i]) i = (i + 1) & mask;
+    map[i] = entity;
+}
+
+static void _LE_HandleMapReserve(_LE_EntityListData* data, int count) {
+    if ((data->numHandles + count) * 2 > data->handleCapacity) {
+        int capacity = data->handleCapacity ? data->handleCapacity * 2 : 64;
+        while ((data->numHandles + count) * 2 > capacity) capacity *= 2;
+        _LE_Entity** map = _LE_Calloc(capacity, sizeof(_LE_Entity*), LE_MemoryTag_Entity);
+        for (int i = 0; i < data->handleCapacity; i++) {
+            if (data->handleMap[i]) _LE_HandleMapPlace(map, capacity, data->handleMap[i]);
+        }
+        _LE_Free(data->handleMap);
+        data->handleMap = map;
+        data->handleCapacity = capacity;
+    }
+}
+
+static void _LE_HandleMapInsert(_LE_EntityListData* data, _LE_Entity* entity) {
+    _LE_HandleMapReserve(data, 1);
+    _LE_HandleMapPlace(data->handleMap, data->handleCapacity, entity);
+    data->numHandles++;
+}
+
+static void _LE_HandleMapRemove(_LE_EntityListData* data, _LE_Entity* entity) {
+    unsigned int mask = data->handleCapacity - 1;
+    unsigned int i = (entity->handle * 2654435761u) & mask;
+    while (data->handleMap[i] != entity) {
+        if (!data->handleMap[i]) return;
+        i = (i + 1) & mask;
+    }
+    data->handleMap[i] = NULL;
+    data->numHandles--;
+    unsigned int j = i;
+    while (data->handleMap[j = (j + 1) & mask]) {
+        _LE_Entity* moved = data->handleMap[j];
+        unsigned int home = (moved->handle * 2654435761u) & mask;
+        if (((j - home) & mask) < ((j - i) & mask)) continue;
+        data->handleMap[i] = moved;
+        data->handleMap[j] = NULL;
+        i = j;
+    }
+}
+
+LE_Entity* LE_EntityFromHandle(LE_EntityList* list, unsigned int handle) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (data->handleCapacity == 0) return NULL;
+    unsigned int mask = data->handleCapacity - 1;
+    unsigned int i = (handle * 2654435761u) & mask;
+    while (data->handleMap[i]) {
+        if (data->handleMap[i]->handle == handle) return (LE_Entity*)data->handleMap[i];
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+unsigned int LE_EntityGetHandle(LE_Entity* entity) {
+    return ((_LE_Entity*)entity)->handle;
+}
+
+static _LE_EntityList* _LE_UnlinkEntity(_LE_Entity* entity) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_EntityList* node = (_LE_EntityList*)entity->parent;
+    _LE_EntityTouch(entity);
+    _LE_EntityGridRemove(data, entity);
+    _LE_HandleMapRemove(data, entity);
+    if (entity->activeIndex >= 0 && entity->activeIndex < data->numActive && data->active[entity->activeIndex] == entity) {
+        data->active[entity->activeIndex] = NULL;
+    }
+    if (entity->deleted && entity->pendingIndex < data->numPendingDelete && data->pendingDelete[entity->pendingIndex] == entity) {
+        data->pendingDelete[entity->pendingIndex] = NULL;
+    }
+    if (entity->alwaysActiveIndex >= 0) {
+        _LE_Entity* last = data->alwaysActive[--data->numAlwaysActive];
+        data->alwaysActive[entity->alwaysActiveIndex] = last;
+        last->alwaysActiveIndex = entity->alwaysActiveIndex;
+        entity->alwaysActiveIndex = -1;
+    }
+    if (entity->drawIndex >= 0) {
+        data->drawOrder[entity->drawIndex] = NULL;
+        data->drawOrderHoles++;
+        entity->drawIndex = -1;
+    }
+    if (data->tail == node) data->tail = node->prev;
+    data->version++;
+    node->prev->next = node->next;
+    if (node->next) node->next->prev = node->prev;
+    entity->parent = NULL;
+    return node;
+}
+
+void _LE_DetachEntity(_LE_Entity* entity) {
+    _LE_Free(_LE_UnlinkEntity(entity));
+}
+
+void _LE_AttachEntity(_LE_Entity* entity, LE_EntityList* list) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    entity->seq = data->nextSeq++;
+    entity->handle = ++data->nextHandle;
+    _LE_LinkEntity(entity, list);
+}
+
+static void _LE_LinkEntityNode(_LE_Entity* entity, LE_EntityList* list, _LE_EntityList* node) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    data->version++;
+    if (node) {
+        node->prev = data->tail;
+        node->next = NULL;
+        node->frst = data->tail->frst;
+        data->tail->next = node;
+        entity->parent = (LE_EntityList*)node;
+    }
+    else entity->parent = LE_LL_Add(data->tail, entity);
+    data->tail = (_LE_EntityList*)entity->parent;
+    _LE_HandleMapInsert(data, entity);
+    entity->syncStamp = 0;
+    _LE_EntityTouch(entity);
+    entity->activeStamp = 0;
+    entity->alwaysActiveIndex = -1;
+    entity->activeIndex = data->numActive;
+    _LE_PushEntity(&data->active, &data->numActive, &data->activeCapacity, entity);
+    if (entity->builder->alwaysActive) {
+        entity->alwaysActiveIndex = data->numAlwaysActive;
+        _LE_PushEntity(&data->alwaysActive, &data->numAlwaysActive, &data->alwaysActiveCapacity, entity);
+    }
+    if (entity->deleted) {
+        entity->pendingIndex = data->numPendingDelete;
+        _LE_PushEntity(&data->pendingDelete, &data->numPendingDelete, &data->pendingDeleteCapacity, entity);
+    }
+    _LE_EntityGridInsert(data, entity);
+    data->idleStep = fmaxf(data->idleStep, _LE_EntityStep(entity));
+    if (data->numDrawOrder > 0 && data->lastDrawPriority > entity->drawPriority) data->drawOrderDirty = true;
+    else data->lastDrawPriority = entity->drawPriority;
+    entity->drawIndex = data->numDrawOrder;
+    entity->sortedPriority = entity->drawPriority;
+    _LE_PushEntity(&data->drawOrder, &data->numDrawOrder, &data->drawOrderCapacity, entity);
+}
+
+void _LE_LinkEntity(_LE_Entity* entity, LE_EntityList* list) {
+    _LE_LinkEntityNode(entity, list, NULL);
+}
+
+static void _LE_MoveEntity(_LE_Entity* entity, LE_EntityList* list) {
+    _LE_EntityListData* from = LE_ENTITY_LIST_DATA(entity->parent);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    unsigned int handle = entity->handle;
+    int index = from->recordIndex;
+    struct _LE_Recording* recording = from->recording;
+    _LE_EndEntityContacts(entity);
+    _LE_EntityList* node = _LE_UnlinkEntity(entity);
+    entity->seq = data->nextSeq++;
+    entity->handle = ++data->nextHandle;
+    _LE_LinkEntityNode(entity, list, node);
+    if (recording) _LE_RecordMove(recording, index, handle, data->recording == recording ? data->recordIndex : -1);
+}
+
+void LE_EntityChangeLists(LE_Entity* entity, LE_EntityList* destlist) {
+    if (LE_EntityGetList(entity) == destlist) return;
+    _LE_MoveEntity((_LE_Entity*)entity, destlist);
+}
+
+void LE_EntitiesChangeLists(LE_Entity** entities, int count, LE_EntityList* destlist) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(destlist);
+    _LE_HandleMapReserve(data, count);
+    for (int i = 0; i < count; i++) {
+        if (!entities[i] || LE_EntityGetList(entities[i]) == destlist) continue;
+        _LE_MoveEntity((_LE_Entity*)entities[i], destlist);
+    }
+}
+
+static int _LE_CompareDrawOrder(const void* left, const void* right) {
+    _LE_Entity* l = *(_LE_Entity**)left;
+    _LE_Entity* r = *(_LE_Entity**)right;
+    if (l->drawPriority != r->drawPriority) return (l->drawPriority > r->drawPriority) - (l->drawPriority < r->drawPriority);
+    return (l->seq > r->seq) - (l->seq < r->seq);
+}
+
+_LE_Entity** _LE_EntityListDrawOrder(LE_EntityList* list, int* count) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    for (int i = data->numSortedDrawOrder; i < data->numDrawOrder; i++) {
+        _LE_Entity* entity = data->drawOrder[i];
+        if (entity && entity->drawPriority != entity->sortedPriority) data->drawOrderChanges++;
+    }
+    if (data->drawOrderChanges) data->drawOrderDirty = true;
+    if (data->drawOrderDirty || data->drawOrderHoles * 2 > data->numDrawOrder) {
+        int changed = data->drawOrderChanges + data->numDrawOrder - data->numSortedDrawOrder;
+        int num = 0;
+        for (int i = 0; i < data->numDrawOrder; i++) {
+            if (data->drawOrder[i]) data->drawOrder[num++] = data->drawOrder[i];
+        }
+        data->numDrawOrder = num;
+        if (data->drawOrderDirty && changed > num / 8) qsort(data->drawOrder, num, sizeof(_LE_Entity*), _LE_CompareDrawOrder);
+        else if (data->drawOrderDirty) for (int i = 1; i < num; i++) {
+            _LE_Entity* entity = data->drawOrder[i];
+            int j = i;
+            while (j > 0 && _LE_CompareDrawOrder(&data->drawOrder[j - 1], &entity) > 0) {
+                data->drawOrder[j] = data->drawOrder[j - 1];
+                j--;
+            }
+            data->drawOrder[j] = entity;
+        }
+        for (int i = 0; i < num; i++) {
+            data->drawOrder[i]->drawIndex = i;
+            data->drawOrder[i]->sortedPriority = data->drawOrder[i]->drawPriority;
+        }
+        if (data->drawOrderDirty) data->version++;
+        data->drawOrderDirty = false;
+        data->drawOrderHoles = data->drawOrderChanges = 0;
+        if (num > 0) data->lastDrawPriority = data->drawOrder[num - 1]->drawPriority;
+    }
+    data->numSortedDrawOrder = data->numDrawOrder;
+    *count = data->numDrawOrder;
+    return data->drawOrder;
 }
 
 void LE_DestroyEntity(LE_Entity* entity) {
     _LE_Entity* e = (_LE_Entity*)entity;
+    if ((void*)e->parent != (void*)((_LE_EntityList*)e->parent)->frst) _LE_EndEntityContacts(e);
+    _LE_DestroyEntity(e);
+}
+
+void _LE_DestroyEntity(_LE_Entity* e) {
     if ((void*)e->parent != (void*)((_LE_EntityList*)e->parent)->frst) {
-        LE_LL_DeepFree(e->properties, free);
-        LE_LL_Remove(((_LE_EntityList*)e->parent)->frst, entity);
+        _LE_EntityListData* data = LE_ENTITY_LIST_DATA(e->parent);
+        if (data->recording) _LE_RecordEntity(data->recording, _LE_RecordEvent_Destroy, data->recordIndex, e->handle, 0, 0);
+        _LE_EntityReleaseProperties(e);
+        _LE_DetachEntity(e);
     }
-    free(entity);
+    _LE_Free(e);
 }
 
 void LE_DestroyEntityInner(LE_Entity* entity) {
     _LE_Entity* e = (_LE_Entity*)entity;
     if ((void*)e->parent != (void*)((_LE_EntityList*)e->parent)->frst) {
-        LE_LL_DeepFree(e->properties, free);
+        _LE_EntityReleaseProperties(e);
+    }
+    else if (e->listData) {
+        LE_EntityList* list = e->parent;
+        while (e->listData->numCollisionLists > 0) LE_EntityListRemoveCollisionList(list, e->listData->collisionLists[0]);
+        while (e->listData->numColliderOf > 0) LE_EntityListRemoveCollisionList(e->listData->colliderOf[0], list);
+        _LE_RegistryRemove(&listRegistry, e->listData->id);
+        _LE_Free(e->listData->batch);
+        _LE_Free(e->listData->batchBuilders);
+        _LE_Free(e->listData->batchOffsets);
+        _LE_Free(e->listData->regions);
+        _LE_Free(e->listData->active);
+        _LE_Free(e->listData->nextActive);
+        _LE_Free(e->listData->alwaysActive);
+        _LE_Free(e->listData->pendingDelete);
+        for (int i = 0; i < e->listData->speculativeCapacity; i++) {
+            _LE_Free(e->listData->speculative[i].ops);
+        }
+        _LE_Free(e->listData->speculative);
+        _LE_Free(e->listData->drawOrder);
+        _LE_Free(e->listData->drawCandidates);
+        _LE_Free(e->listData->handleMap);
+        _LE_Free(e->listData->candidates);
+        _LE_Free(e->listData->contacts);
+        _LE_Free(e->listData->contactIndex);
+        _LE_Free(e->listData->contactEvents);
+        _LE_Free(e->listData->collisionLists);
+        _LE_Free(e->listData->colliderOf);
+        _LE_Free(e->listData->sync.handles);
+        _LE_Free(e->listData->sync.tiles);
+        _LE_GridFree(&e->listData->grid);
+        _LE_GridFree(&e->listData->staticGrid);
+        _LE_Free(e->listData);
     }
-    free(entity);
+    _LE_Free(entity);
 }
 
 void LE_DestroyEntityList(LE_EntityList* list) {
@@ -325,7 +1271,7 @@ LE_EntityList* LE_EntityGetList(LE_Entity* entity) {
 }
 
 LE_Tilemap* LE_EntityGetTilemap(LE_EntityList* list) {
-    return ((_LE_EntityList*)list)->value->tilemap;
+    return ((_LE_EntityList*)list)->value->listData->tilemap;
 }
 
 LE_EntityListIter* LE_EntityListGetIter(LE_EntityList* list) {
@@ -0,0 +1,242 @@
+#ifndef LUNAR_ENGINE_ENTITY_H
+#define LUNAR_ENGINE_ENTITY_H
+
+#include <stdatomic.h>
+
+#include "linked_list.h"
+#include "lunarengine.h"
+#include "spatial.h"
+
+typedef struct {
+    char* name;
+    LE_EntityProperty value;
+} _LE_EntityProperty;
+
+typedef DEFINE_LIST(_LE_EntityProperty) _LE_EntityPropList;
+
+typedef struct {
+    atomic_int refcount;
+    _LE_EntityPropList* properties;
+} _LE_PropertyBlock;
+
+typedef struct {
+    void** callbacks;
+    int count, capacity;
+} _LE_CallbackArray;
+
+typedef struct _LE_EntityBuilder {
+    _LE_CallbackArray textureCallbacks;
+    _LE_CallbackArray updateCallbacks;
+    _LE_CallbackArray batchUpdateCallbacks;
+    _LE_CallbackArray collisionCallbacks;
+    _LE_CallbackArray contactCallbacks;
+    _LE_CallbackArray wakeCallbacks;
+    _LE_CallbackArray sleepCallbacks;
+    _LE_EntityPropList* properties;
+    _LE_PropertyBlock* _Atomic propertyBlock;
+    float width, height;
+    int defaultDrawPriority;
+    LE_EntityFlags flags;
+    bool alwaysActive;
+    unsigned int category, mask;
+    char* name;
+    bool spriteCache;
+    char* spriteKey;
+    unsigned int id;
+} _LE_EntityBuilder;
+
+typedef struct {
+    void* texture;
+    float width, height;
+    int srcX, srcY, srcW, srcH;
+} _LE_SpriteState;
+
+typedef struct _LE_Entity {
+    float posX, posY;
+    float velX, velY;
+    float width, height;
+    int drawPriority;
+    LE_EntityFlags flags;
+    float prevPosX, prevPosY;
+    float lastDrawnX, lastDrawnY;
+    bool deleted;
+    LE_Entity* platform;
+    _LE_EntityPropList* properties;
+    _LE_PropertyBlock* sharedProperties;
+    _LE_EntityBuilder* builder;
+    LE_EntityList* parent;
+    struct _LE_EntityListData* listData;
+    unsigned long long seq;
+    _LE_GridCell* cell;
+    struct _LE_Entity* cellNext;
+    struct _LE_Entity* cellPrev;
+    unsigned int activeStamp;
+    bool dormant;
+    int activeIndex;
+    int alwaysActiveIndex;
+    int pendingIndex;
+    unsigned int handle;
+    int drawIndex;
+    int sortedPriority;
+    float spriteW, spriteH;
+    _LE_SpriteState sprite;
+    bool spriteCached;
+    unsigned int category, mask;
+    bool staticCell;
+    float recordVelX, recordVelY;
+    unsigned int syncStamp;
+} _LE_Entity;
+
+typedef struct {
+    bool used;
+    bool camera;
+    LE_LayerList* layers;
+    float x, y, w, h;
+} _LE_ActivationRegion;
+
+typedef struct {
+    unsigned int entity;
+    unsigned int collider;
+    LE_EntityList* colliderList;
+    LE_TileData* tile;
+    int tileX, tileY;
+    LE_Direction direction;
+    unsigned int stamp;
+    LE_ContactPhase phase;
+} _LE_Contact;
+
+typedef struct {
+    float posX, posY;
+    float width, height;
+    LE_EntityFlags flags;
+    LE_Entity* platform;
+    unsigned int category, mask;
+    bool deleted;
+} _LE_CollisionState;
+
+typedef enum {
+    _LE_DeferredOp_Property,
+    _LE_DeferredOp_DelProperty,
+    _LE_DeferredOp_Delete,
+    _LE_DeferredOp_Position
+} _LE_DeferredOpType;
+
+typedef struct {
+    _LE_DeferredOpType type;
+    LE_EntityProperty value;
+    char* name;
+    float x, y;
+} _LE_DeferredOp;
+
+typedef struct {
+    _LE_CollisionState state;
+    _LE_DeferredOp* ops;
+    int numOps, opCapacity;
+} _LE_SpeculativeEntity;
+
+typedef struct {
+    unsigned long long generation;
+    unsigned int stamp;
+    unsigned int* handles;
+    int numHandles, handleCapacity;
+    LE_Tilemap* tilemap;
+    unsigned int tileVersion;
+    int* tiles;
+    int numTiles, tileCapacity;
+} _LE_SnapshotSync;
+
+typedef struct _LE_EntityListData {
+    unsigned int id;
+    LE_Tilemap* tilemap;
+    _LE_Entity** batch;
+    int batchCapacity;
+    _LE_EntityBuilder** batchBuilders;
+    int* batchOffsets;
+    int batchBuilderCapacity;
+    _LE_Grid grid;
+    _LE_Grid staticGrid;
+    unsigned long long nextSeq;
+    _LE_ActivationRegion* regions;
+    int numRegions, regionCapacity;
+    unsigned int activeStamp;
+    _LE_Entity** active;
+    int numActive, activeCapacity;
+    _LE_Entity** nextActive;
+    int numNextActive, nextActiveCapacity;
+    _LE_Entity** alwaysActive;
+    int numAlwaysActive, alwaysActiveCapacity;
+    _LE_Entity** pendingDelete;
+    int numPendingDelete, pendingDeleteCapacity;
+    bool parallel;
+    _LE_SpeculativeEntity* speculative;
+    int speculativeCapacity;
+    _LE_Entity** drawOrder;
+    int numDrawOrder, drawOrderCapacity;
+    bool drawOrderDirty;
+    int numSortedDrawOrder;
+    int drawOrderHoles, drawOrderChanges;
+    int lastDrawPriority;
+    _LE_Entity** drawCandidates;
+    int numDrawCandidates, drawCandidateCapacity;
+    float maxSpriteW, maxSpriteH;
+    float maxStep, idleStep;
+    _LE_Entity** handleMap;
+    int numHandles, handleCapacity;
+    unsigned int nextHandle;
+    struct LinkedList__LE_Entity* tail;
+    _LE_Entity** candidates;
+    int numCandidates, candidateCapacity;
+    bool contactCache;
+    _LE_Contact* contacts;
+    int numContacts, contactCapacity;
+    _LE_Contact* contactEvents;
+    int contactEventCapacity;
+    int* contactIndex;
+    int contactIndexCapacity;
+    unsigned int contactStamp;
+    unsigned int version;
+    struct _LE_Recording* recording;
+    int recordIndex;
+    LE_EntityList** collisionLists;
+    int numCollisionLists, collisionListCapacity;
+    LE_EntityList** colliderOf;
+    int numColliderOf, colliderOfCapacity;
+    _LE_SnapshotSync sync;
+} _LE_EntityListData;
+
+typedef DEFINE_LIST(_LE_Entity) _LE_EntityList;
+
+#define LE_PARALLEL_MIN_ENTITIES 64
+
+#define LE_ENTITIES_INTERACT(a, b) (((a)->mask & (b)->category) && ((b)->mask & (a)->category))
+#define LE_ENTITY_LIST_DATA(list) (((_LE_EntityList*)((_LE_EntityList*)(list))->frst)->value->listData)
+
+void _LE_CallbackArrayAdd(_LE_CallbackArray* array, void* callback);
+_LE_EntityBuilder* _LE_BuilderFromId(unsigned int id);
+LE_EntityList* _LE_ListFromId(unsigned int id);
+_LE_EntityPropList* _LE_AppendProperty(_LE_EntityPropList* tail, LE_EntityProperty property, const char* name);
+void _LE_EntityOwnProperties(_LE_Entity* entity);
+void _LE_EntityShareProperties(_LE_Entity* entity);
+void _LE_EntityReleaseProperties(_LE_Entity* entity);
+void _LE_SyncAddHandle(_LE_SnapshotSync* sync, unsigned int handle);
+void _LE_EntityTouch(_LE_Entity* entity);
+void _LE_PushEntity(_LE_Entity*** array, int* count, int* capacity, _LE_Entity* entity);
+void _LE_AttachEntity(_LE_Entity* entity, LE_EntityList* list);
+void _LE_LinkEntity(_LE_Entity* entity, LE_EntityList* list);
+void _LE_DetachEntity(_LE_Entity* entity);
+void _LE_DestroyEntity(_LE_Entity* entity);
+_LE_Entity** _LE_EntityListDrawOrder(LE_EntityList* list, int* count);
+float _LE_EntityStep(_LE_Entity* entity);
+_LE_Entity** _LE_EntityListDrawCandidates(LE_EntityList* list, float x1, float y1, float x2, float y2, int tileW, int tileH, int* count);
+void _LE_EntityGridInsert(_LE_EntityListData* data, _LE_Entity* entity);
+void _LE_EntityGridRemove(_LE_EntityListData* data, _LE_Entity* entity);
+void _LE_EntityGridUpdate(_LE_EntityListData* data, _LE_Entity* entity, bool moved);
+void _LE_RecordEntityContact(_LE_EntityListData* data, _LE_Entity* entity, _LE_Entity* collider);
+void _LE_RecordTileContact(_LE_EntityListData* data, _LE_Entity* entity, LE_TileData* tile, int tileX, int tileY, LE_Direction direction);
+void _LE_DispatchContacts(LE_EntityList* list);
+void _LE_EndEntityContacts(_LE_Entity* entity);
+void _LE_RebuildContactIndex(_LE_EntityListData* data);
+bool _LE_EntityGridQuery(_LE_EntityListData* data, float x1, float y1, float x2, float y2, _LE_GridVisitor visitor, void* userdata);
+bool _LE_EntityGridRaycast(_LE_EntityListData* data, float x, float y, float dirX, float dirY, float* maxDistance, _LE_GridVisitor visitor, void* userdata);
+
+#endif
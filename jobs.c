@@ -0,0 +1,185 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jobs.h"
+#include "lunarengine.h"
+#include "memory.h"
+
+typedef struct {
+    _LE_JobFunc func;
+    void* userdata;
+    atomic_int remaining;
+} _LE_JobBatch;
+
+typedef struct {
+    _LE_JobBatch* batch;
+    int start, end;
+} _LE_Job;
+
+typedef struct {
+    pthread_mutex_t lock;
+    _LE_Job* jobs;
+    int head, count, capacity;
+} _LE_JobQueue;
+
+static struct {
+    pthread_t* threads;
+    _LE_JobQueue* queues;
+    int numThreads;
+    atomic_int pending;
+    atomic_bool shutdown;
+    pthread_mutex_t sleepLock;
+    pthread_cond_t wake;
+} pool = { .sleepLock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+
+static _Thread_local int workerIndex = -1;
+static _Thread_local bool inlineJobs = false;
+
+static _LE_JobQueue* _LE_OwnQueue() {
+    return &pool.queues[workerIndex < 0 ? pool.numThreads : workerIndex];
+}
+
+static void _LE_QueuePush(_LE_JobQueue* queue, _LE_Job job) {
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 64;
+        _LE_Job* jobs = _LE_Malloc(sizeof(_LE_Job) * capacity, LE_MemoryTag_Jobs);
+        for (int i = 0; i < queue->count; i++) {
+            jobs[i] = queue->jobs[(queue->head + i) % queue->capacity];
+        }
+        _LE_Free(queue->jobs);
+        queue->jobs = jobs;
+        queue->head = 0;
+        queue->capacity = capacity;
+    }
+    queue->jobs[(queue->head + queue->count++) % queue->capacity] = job;
+    pthread_mutex_unlock(&queue->lock);
+    atomic_fetch_add(&pool.pending, 1);
+}
+
+static bool _LE_QueuePop(_LE_JobQueue* queue, _LE_Job* job, bool steal) {
+    bool found = false;
+    pthread_mutex_lock(&queue->lock);
+    if (queue->count > 0) {
+        if (steal) {
+            *job = queue->jobs[queue->head];
+            queue->head = (queue->head + 1) % queue->capacity;
+        }
+        else *job = queue->jobs[(queue->head + queue->count - 1) % queue->capacity];
+        queue->count--;
+        found = true;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    if (found) atomic_fetch_sub(&pool.pending, 1);
+    return found;
+}
+
+static bool _LE_FindJob(_LE_Job* job) {
+    int own = workerIndex < 0 ? pool.numThreads : workerIndex;
+    if (_LE_QueuePop(&pool.queues[own], job, false)) return true;
+    for (int i = 1; i <= pool.numThreads; i++) {
+        if (_LE_QueuePop(&pool.queues[(own + i) % (pool.numThreads + 1)], job, true)) return true;
+    }
+    return false;
+}
+
+static void _LE_RunJob(_LE_Job* job) {
+    job->batch->func(job->batch->userdata, job->start, job->end);
+    atomic_fetch_sub(&job->batch->remaining, 1);
+}
+
+static void* _LE_WorkerMain(void* arg) {
+    workerIndex = (int)(size_t)arg;
+    _LE_Job job;
+    while (true) {
+        if (_LE_FindJob(&job)) {
+            _LE_RunJob(&job);
+            continue;
+        }
+        pthread_mutex_lock(&pool.sleepLock);
+        while (atomic_load(&pool.pending) == 0 && !atomic_load(&pool.shutdown)) {
+            pthread_cond_wait(&pool.wake, &pool.sleepLock);
+        }
+        pthread_mutex_unlock(&pool.sleepLock);
+        if (atomic_load(&pool.shutdown)) break;
+    }
+    return NULL;
+}
+
+void LE_SetWorkerThreads(int count) {
+    if (count < 0) count = 0;
+    if (pool.numThreads > 0) {
+        pthread_mutex_lock(&pool.sleepLock);
+        atomic_store(&pool.shutdown, true);
+        pthread_cond_broadcast(&pool.wake);
+        pthread_mutex_unlock(&pool.sleepLock);
+        for (int i = 0; i < pool.numThreads; i++) {
+            pthread_join(pool.threads[i], NULL);
+        }
+        for (int i = 0; i <= pool.numThreads; i++) {
+            pthread_mutex_destroy(&pool.queues[i].lock);
+            _LE_Free(pool.queues[i].jobs);
+        }
+        _LE_Free(pool.threads);
+        _LE_Free(pool.queues);
+        pool.threads = NULL;
+        pool.queues = NULL;
+        pool.numThreads = 0;
+    }
+    if (count == 0) return;
+    atomic_store(&pool.shutdown, false);
+    atomic_store(&pool.pending, 0);
+    pool.queues = _LE_Malloc(sizeof(_LE_JobQueue) * (count + 1), LE_MemoryTag_Jobs);
+    memset(pool.queues, 0, sizeof(_LE_JobQueue) * (count + 1));
+    for (int i = 0; i <= count; i++) {
+        pthread_mutex_init(&pool.queues[i].lock, NULL);
+    }
+    pool.numThreads = count;
+    pool.threads = _LE_Malloc(sizeof(pthread_t) * count, LE_MemoryTag_Jobs);
+    for (int i = 0; i < count; i++) {
+        pthread_create(&pool.threads[i], NULL, _LE_WorkerMain, (void*)(size_t)i);
+    }
+}
+
+int LE_GetWorkerThreads() {
+    return pool.numThreads;
+}
+
+int _LE_JobsThreadCount() {
+    return pool.numThreads;
+}
+
+bool _LE_JobsSetInline(bool inline_) {
+    bool prev = inlineJobs;
+    inlineJobs = inline_;
+    return prev;
+}
+
+void _LE_JobsParallelFor(int count, int grain, _LE_JobFunc func, void* userdata) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+    if (pool.numThreads == 0 || count <= grain || inlineJobs) {
+        func(userdata, 0, count);
+        return;
+    }
+    _LE_JobBatch batch;
+    batch.func = func;
+    batch.userdata = userdata;
+    atomic_init(&batch.remaining, (count + grain - 1) / grain);
+    _LE_JobQueue* queue = _LE_OwnQueue();
+    for (int end = count; end > 0; end -= grain) {
+        int start = end - grain < 0 ? 0 : end - grain;
+        _LE_QueuePush(queue, (_LE_Job){ &batch, start, end });
+    }
+    pthread_mutex_lock(&pool.sleepLock);
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.sleepLock);
+    _LE_Job job;
+    while (atomic_load(&batch.remaining) > 0) {
+        if (_LE_FindJob(&job)) _LE_RunJob(&job);
+        else sched_yield();
+    }
+}
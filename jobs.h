@@ -0,0 +1,12 @@
+#ifndef LUNAR_ENGINE_JOBS_H
+#define LUNAR_ENGINE_JOBS_H
+
+#include <stdbool.h>
+
+typedef void(*_LE_JobFunc)(void* userdata, int start, int end);
+
+int  _LE_JobsThreadCount();
+bool _LE_JobsSetInline(bool inline_);
+void _LE_JobsParallelFor(int count, int grain, _LE_JobFunc func, void* userdata);
+
+#endif
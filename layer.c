@@ -1,49 +1,37 @@
+#include "drawlist.h"
+#include "entity.h"
+#include "jobs.h"
+#include "layer.h"
 #include "linked_list.h"
 #include "lunarengine.h"
+#include "memory.h"
+#include "profile.h"
+#include "record.h"
+#include "tile.h"
 
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct {
-    float scrollOffsetX, scrollSpeedX;
-    float scrollOffsetY, scrollSpeedY;
-    float scaleW, scaleH;
-    float prevScrollOffsetX, prevScrollSpeedX;
-    float prevScrollOffsetY, prevScrollSpeedY;
-    float prevScaleW, prevScaleH;
-    LE_LayerType type;
-    void* ptr;
-    LE_LayerList* parent;
-    struct {
-        float camPosX;
-        float camPosY;
-        float prevCamPosX;
-        float prevCamPosY;
-    } cameraData;
-} _LE_Layer;
-
-typedef struct {
-    void* params;
-    CustomLayer callback;
-} _LE_CustomLayer;
-
-typedef DEFINE_LIST(_LE_Layer) _LE_LayerList;
-
 LE_LayerList* LE_CreateLayerList() {
     struct LinkedList__LE_Layer* list = LE_LL_Create();
-    list->value = malloc(sizeof(_LE_Layer));
-    list->value->cameraData.camPosX = 0;
-    list->value->cameraData.camPosY = 0;
+    list->value = _LE_Malloc(sizeof(_LE_Layer), LE_MemoryTag_Layer);
+    memset(list->value, 0, sizeof(_LE_Layer));
     return (LE_LayerList*)list;
 }
 
 LE_Layer* LE_MakeLayer(LE_LayerList* layers, void* data, LE_LayerType type) {
-    _LE_Layer* l = malloc(sizeof(_LE_Layer));
+    _LE_Layer* l = _LE_Malloc(sizeof(_LE_Layer), LE_MemoryTag_Layer);
     l->scrollOffsetX = l->scrollOffsetY = 0;
     l->scrollSpeedX = l->scrollSpeedY = 1;
     l->scaleW = l->scaleH = 1;
     l->type = type;
     l->ptr = data;
+    l->scratch = NULL;
+    l->threadSafe = type != LE_LayerType_Custom;
+    l->retained = false;
+    l->cacheValid = false;
+    l->cache = NULL;
+    l->cacheHits = l->cacheMisses = 0;
     l->parent = (LE_LayerList*)LE_LL_Add(layers, l);
     return (LE_Layer*)l;
 }
@@ -57,7 +45,7 @@ LE_Layer* LE_AddEntityLayer(LE_LayerList* layers, LE_EntityList* entities) {
 }
 
 LE_Layer* LE_AddCustomLayer(LE_LayerList* layers, CustomLayer callback, void* params) {
-    _LE_CustomLayer* layer = malloc(sizeof(_LE_CustomLayer));
+    _LE_CustomLayer* layer = _LE_Malloc(sizeof(_LE_CustomLayer), LE_MemoryTag_Layer);
     layer->callback = callback;
     layer->params = params;
     return LE_MakeLayer(layers, layer, LE_LayerType_Custom);
@@ -104,6 +92,7 @@ void LE_ScrollCamera(LE_LayerList* layers, float camX, float camY) {
     _LE_LayerList* ll = (_LE_LayerList*)layers;
     ll->value->cameraData.camPosX = camX;
     ll->value->cameraData.camPosY = camY;
+    if (ll->value->cameraData.recording) _LE_RecordCamera(ll->value->cameraData.recording, camX, camY);
 }
 
 void LE_GetCameraPos(LE_LayerList* layers, float* camX, float* camY) {
@@ -130,6 +119,15 @@ void* LE_LayerGetDataPointer(LE_Layer* layer) {
     return ((_LE_Layer*)layer)->ptr;
 }
 
+void* LE_LayerSetDataPointer(LE_Layer* layer, void* ptr) {
+    _LE_Layer* l = (_LE_Layer*)layer;
+    if (l->type == LE_LayerType_Custom) return NULL;
+    void* prev = l->ptr;
+    l->ptr = ptr;
+    l->cacheValid = false;
+    return prev;
+}
+
 void LE_UpdateLayerList(LE_LayerList* layers) {
     _LE_LayerList* ll = (_LE_LayerList*)layers;
     ll->value->cameraData.prevCamPosX = ll->value->cameraData.camPosX;
@@ -145,18 +143,133 @@ void LE_UpdateLayerList(LE_LayerList* layers) {
     }
 }
 
+void LE_LayerSetThreadSafe(LE_Layer* layer, bool threadSafe) {
+    ((_LE_Layer*)layer)->threadSafe = threadSafe;
+}
+
+void LE_LayerSetRetained(LE_Layer* layer, bool retained) {
+    _LE_Layer* l = (_LE_Layer*)layer;
+    l->retained = retained;
+    l->cacheValid = false;
+    if (!retained && l->cache) {
+        LE_DestroyDrawList(l->cache);
+        l->cache = NULL;
+    }
+}
+
+void LE_LayerInvalidate(LE_Layer* layer) {
+    ((_LE_Layer*)layer)->cacheValid = false;
+}
+
+void LE_LayerGetCacheStats(LE_Layer* layer, int* hits, int* misses) {
+    _LE_Layer* l = (_LE_Layer*)layer;
+    if (hits)   *hits   = l->cacheHits;
+    if (misses) *misses = l->cacheMisses;
+}
+
+static unsigned int _LE_LayerVersion(_LE_Layer* l) {
+    switch (l->type) {
+        case LE_LayerType_Tilemap:
+            return ((_LE_Tilemap*)l->ptr)->version;
+        case LE_LayerType_Entity: {
+            int num;
+            _LE_EntityListDrawOrder(l->ptr, &num);
+            _LE_Tilemap* tilemap = (_LE_Tilemap*)LE_EntityGetTilemap(l->ptr);
+            return LE_ENTITY_LIST_DATA(l->ptr)->version * 31 + (tilemap ? tilemap->version : 0);
+        }
+        default:
+            return 0;
+    }
+}
+
+static void _LE_LayerRetain(_LE_Layer* l, _LE_LayerCacheKey* key, LE_DrawList* dl, int start) {
+    _LE_DrawList* drawlist = (_LE_DrawList*)dl;
+    if (!l->cache) l->cache = LE_CreateDrawList();
+    LE_ClearDrawList(l->cache);
+    _LE_DrawListCopy(l->cache, dl, start, drawlist->size);
+    l->cacheKey = *key;
+    l->cacheColorMark = drawlist->colorMark >= start ? drawlist->colorMark - start : -1;
+    l->cacheEndColor = drawlist->color;
+    l->cacheValid = true;
+}
+
+static void _LE_LayerReplay(_LE_Layer* l, LE_DrawList* dl) {
+    int count = LE_DrawListSize(l->cache);
+    int mark = l->cacheColorMark < 0 ? count : l->cacheColorMark;
+    _LE_DrawListCopy(dl, l->cache, 0, mark);
+    if (l->cacheColorMark >= 0 || l->cacheEndColor != LE_DrawGetColor(dl)) LE_DrawSetColor(dl, l->cacheEndColor);
+    _LE_DrawListCopy(dl, l->cache, mark, count);
+    LE_PROFILE_COUNT(_LE_Counter_QuadsEmitted, count);
+}
+
+void LE_LayerListSetParallelDraw(LE_LayerList* layers, bool parallel) {
+    ((_LE_LayerList*)layers)->value->cameraData.parallelDraw = parallel;
+}
+
+typedef struct {
+    _LE_Layer** layers;
+    int screenW, screenH;
+    float interpolation;
+} _LE_DrawJob;
+
+static void _LE_DrawLayerJob(void* userdata, int start, int end) {
+    _LE_DrawJob* job = userdata;
+    for (int i = start; i < end; i++) {
+        _LE_Layer* layer = job->layers[i];
+        if (layer->drawSerial) continue;
+        LE_DrawSingleLayer((LE_Layer*)layer, job->screenW, job->screenH, job->interpolation, layer->scratch);
+    }
+}
+
+static void _LE_DrawParallel(_LE_LayerList* ll, int screenW, int screenH, float interpolation, LE_DrawList* dl) {
+    _LE_Layer* head = ll->value;
+    int count = 0;
+    for (_LE_LayerList* curr = ll->next; curr; curr = curr->next) count++;
+    if (count > head->cameraData.drawCapacity) {
+        head->cameraData.drawCapacity = count;
+        head->cameraData.drawLayers = _LE_Realloc(head->cameraData.drawLayers, sizeof(_LE_Layer*) * count, LE_MemoryTag_Layer);
+    }
+    _LE_Layer** layers = head->cameraData.drawLayers;
+    int index = count;
+    for (_LE_LayerList* curr = ll->next; curr; curr = curr->next) layers[--index] = curr->value;
+    for (int i = 0; i < count; i++) {
+        _LE_Layer* layer = layers[i];
+        if (!layer->scratch) layer->scratch = LE_CreateDrawList();
+        LE_DrawListSetTransient(layer->scratch, ((_LE_DrawList*)dl)->transient);
+        LE_DrawListSetFormat(layer->scratch, ((_LE_DrawList*)dl)->format);
+        LE_ClearDrawList(layer->scratch);
+        _LE_DrawListLendSegment(dl, layer->scratch);
+        layer->drawSerial = !layer->threadSafe;
+        if (layer->type != LE_LayerType_Entity) continue;
+        int num;
+        _LE_EntityListDrawOrder(layer->ptr, &num);
+        for (int j = 0; j < i && !layer->drawSerial; j++) {
+            if (layers[j]->type == LE_LayerType_Entity && layers[j]->ptr == layer->ptr) layer->drawSerial = true;
+        }
+    }
+    _LE_DrawJob job = { layers, screenW, screenH, interpolation };
+    _LE_JobsParallelFor(count, 1, _LE_DrawLayerJob, &job);
+    for (int i = 0; i < count; i++) {
+        if (layers[i]->drawSerial) LE_DrawSingleLayer((LE_Layer*)layers[i], screenW, screenH, interpolation, layers[i]->scratch);
+        _LE_DrawListSetStartColor(layers[i]->scratch, LE_DrawGetColor(dl));
+        LE_DrawListConcat(dl, layers[i]->scratch);
+        _LE_DrawListReturnSpares(layers[i]->scratch, dl);
+        LE_DrawSetColor(dl, LE_DrawGetColor(layers[i]->scratch));
+    }
+}
+
 void LE_Draw(LE_LayerList* layers, int screenW, int screenH, float interpolation, LE_DrawList* dl) {
+    _LE_LayerList* ll = (_LE_LayerList*)layers;
+    if (ll->value->cameraData.parallelDraw && _LE_JobsThreadCount() > 0) {
+        _LE_DrawParallel(ll, screenW, screenH, interpolation, dl);
+        return;
+    }
     for (int i = LE_LL_Size(layers) - 1; i >= 0; i--) {
         LE_DrawSingleLayer((LE_Layer*)LE_LL_Get(layers, i), screenW, screenH, interpolation, dl);
     }
 }
 
-static int sort_entities(const void* left, const void* right) {
-    return (*(LE_Entity**)left)->drawPriority - (*(LE_Entity**)right)->drawPriority;
-}
-
 void LE_DrawSingleLayer(LE_Layer* layer, int screenW, int screenH, float interpolation, LE_DrawList* dl) {
-    extern void LE_EntityGetPrevPosition(LE_Entity* entity, float* x, float* y);
     _LE_Layer* l = (_LE_Layer*)layer;
     _LE_LayerList* ll = ((_LE_LayerList*)l->parent)->frst;
 
@@ -177,6 +290,7 @@ void LE_DrawSingleLayer(LE_Layer* layer, int screenW, int screenH, float interpo
         }
     }
 
+    LE_PROFILE_BEGIN(draw);
     float camPosX = (ll->value->cameraData.camPosX - ll->value->cameraData.prevCamPosX) * interpolation + ll->value->cameraData.prevCamPosX;
     float camPosY = (ll->value->cameraData.camPosY - ll->value->cameraData.prevCamPosY) * interpolation + ll->value->cameraData.prevCamPosY;
     float scaleW = (l->prevScaleW - l->scaleW) * interpolation + l->prevScaleW;
@@ -192,28 +306,49 @@ void LE_DrawSingleLayer(LE_Layer* layer, int screenW, int screenH, float interpo
     float tly = offsetY - 1;
     float brx = offsetX + screenW / scaleW / tileW + 1;
     float bry = offsetY + screenH / scaleH / tileH + 1;
+    _LE_LayerCacheKey key;
+    int start = 0;
+    if (l->retained) {
+        memset(&key, 0, sizeof(key));
+        key.offsetX = offsetX;
+        key.offsetY = offsetY;
+        key.scaleW = scaleW;
+        key.scaleH = scaleH;
+        key.interpolation = l->type == LE_LayerType_Entity ? interpolation : 0;
+        key.screenW = screenW;
+        key.screenH = screenH;
+        key.version = _LE_LayerVersion(l);
+        key.color = LE_DrawGetColor(dl);
+        if (l->cacheValid && memcmp(&key, &l->cacheKey, sizeof(key)) == 0) {
+            l->cacheHits++;
+            _LE_LayerReplay(l, dl);
+            LE_PROFILE_END_LAYER(draw, layer);
+            return;
+        }
+        l->cacheMisses++;
+        start = LE_DrawListSize(dl);
+    }
     switch (l->type) {
         case LE_LayerType_Tilemap: {
             LE_DrawPartialTilemap(l->ptr, -offsetX, -offsetY, tlx, tly, brx, bry, scaleW, scaleH, dl);
         } break;
         case LE_LayerType_Entity: {
-            int index = 0;
-            int num_ents = LE_NumEntities(l->ptr);
-            LE_Entity* entities[num_ents];
-            LE_EntityListIter* iter = LE_EntityListGetIter(l->ptr);
-            while (iter) {
-                entities[index++] = LE_EntityListGet(iter);
-                iter = LE_EntityListNext(iter);
-            }
-            qsort(entities, num_ents, sizeof(*entities), sort_entities);
+            _LE_EntityListData* data = LE_ENTITY_LIST_DATA(l->ptr);
+            int num_ents;
+            _LE_Entity** entities = _LE_EntityListDrawCandidates(l->ptr, tlx, tly, brx, bry, tileW, tileH, &num_ents);
             for (int i = 0; i < num_ents; i++) {
-                LE_Entity* entity = entities[i];
-                if (LE_EntityIsDeleted(entity)) continue;
-                float prevX, prevY;
-                LE_EntityGetPrevPosition(entity, &prevX, &prevY);
-                float x = (entity->posX - prevX) * interpolation + prevX;
-                float y = (entity->posY - prevY) * interpolation + prevY;
-                LE_DrawEntity(entity, (x - offsetX) * tileW * scaleW, (y - offsetY) * tileH * scaleH, scaleW, scaleH, dl);
+                _LE_Entity* entity = entities[i];
+                if (entity->deleted) continue;
+                float x = (entity->posX - entity->prevPosX) * interpolation + entity->prevPosX;
+                float y = (entity->posY - entity->prevPosY) * interpolation + entity->prevPosY;
+                float spriteW = entity->spriteW >= 0 ? entity->spriteW : data->maxSpriteW;
+                float spriteH = entity->spriteH >= 0 ? entity->spriteH : data->maxSpriteH;
+                float halfW = spriteW / tileW / 2;
+                float height = spriteH / tileH;
+                if (halfW < entity->width / 2) halfW = entity->width / 2;
+                if (height < entity->height) height = entity->height;
+                if (x + halfW < tlx || x - halfW > brx || y < tly || y - height > bry) continue;
+                LE_DrawEntity((LE_Entity*)entity, (x - offsetX) * tileW * scaleW, (y - offsetY) * tileH * scaleH, scaleW, scaleH, dl);
             }
         } break;
         case LE_LayerType_Custom: {
@@ -221,12 +356,16 @@ void LE_DrawSingleLayer(LE_Layer* layer, int screenW, int screenH, float interpo
             custom->callback(dl, custom->params, offsetX, offsetY, scaleW, scaleH);
         } break;
     }
+    if (l->retained) _LE_LayerRetain(l, &key, dl, start);
+    LE_PROFILE_END_LAYER(draw, layer);
 }
 
 void LE_DisposeLayer(LE_Layer* layer) {
     _LE_Layer* l = (_LE_Layer*)layer;
-    if (l->type == LE_LayerType_Custom) free(l->ptr);
-    free(layer);
+    if (l->type == LE_LayerType_Custom) _LE_Free(l->ptr);
+    if (l->scratch) LE_DestroyDrawList(l->scratch);
+    if (l->cache) LE_DestroyDrawList(l->cache);
+    _LE_Free(layer);
 }
 
 void LE_DestroyLayer(LE_Layer* layer) {
@@ -236,6 +375,7 @@ void LE_DestroyLayer(LE_Layer* layer) {
 }
 
 void LE_DestroyLayerList(LE_LayerList* layers) {
+    _LE_Free(((_LE_LayerList*)layers)->value->cameraData.drawLayers);
     LE_LL_DeepFree(layers, (void(*)(void*))LE_DisposeLayer);
 }
 
@@ -0,0 +1,55 @@
+#ifndef LUNAR_ENGINE_LAYER_H
+#define LUNAR_ENGINE_LAYER_H
+
+#include "linked_list.h"
+#include "lunarengine.h"
+
+typedef struct {
+    float offsetX, offsetY;
+    float scaleW, scaleH;
+    float interpolation;
+    int screenW, screenH;
+    unsigned int version;
+    unsigned int color;
+} _LE_LayerCacheKey;
+
+typedef struct _LE_Layer {
+    float scrollOffsetX, scrollSpeedX;
+    float scrollOffsetY, scrollSpeedY;
+    float scaleW, scaleH;
+    float prevScrollOffsetX, prevScrollSpeedX;
+    float prevScrollOffsetY, prevScrollSpeedY;
+    float prevScaleW, prevScaleH;
+    LE_LayerType type;
+    void* ptr;
+    LE_LayerList* parent;
+    LE_DrawList* scratch;
+    bool threadSafe;
+    bool drawSerial;
+    bool retained;
+    bool cacheValid;
+    LE_DrawList* cache;
+    _LE_LayerCacheKey cacheKey;
+    int cacheColorMark;
+    unsigned int cacheEndColor;
+    int cacheHits, cacheMisses;
+    struct {
+        float camPosX;
+        float camPosY;
+        float prevCamPosX;
+        float prevCamPosY;
+        bool parallelDraw;
+        struct _LE_Layer** drawLayers;
+        int drawCapacity;
+        struct _LE_Recording* recording;
+    } cameraData;
+} _LE_Layer;
+
+typedef struct {
+    void* params;
+    CustomLayer callback;
+} _LE_CustomLayer;
+
+typedef DEFINE_LIST(_LE_Layer) _LE_LayerList;
+
+#endif
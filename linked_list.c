@@ -1,11 +1,12 @@
 #include <stdlib.h>
 
 #include "linked_list.h"
+#include "memory.h"
 
 DEFINE_LIST(void);
 
 void* LE_LL_Create() {
-    struct LinkedList_void* list = malloc(sizeof(struct LinkedList_void));
+    struct LinkedList_void* list = _LE_Malloc(sizeof(struct LinkedList_void), LE_MemoryTag_List);
     list->next = NULL;
     list->prev = NULL;
     list->value = NULL;
@@ -24,7 +25,7 @@ void LE_LL_DeepFree(void* list, void(*dispose)(void*)) {
     while (ll) {
         struct LinkedList_void* next = ll->next;
         if (ll->value) dispose(ll->value);
-        free(ll);
+        _LE_Free(ll);
         ll = next;
     }
 }
@@ -39,7 +40,7 @@ void LE_LL_DeepClear(void* list, void(*dispose)(void*)) {
         struct LinkedList_void* next = ll->next;
         if (ll->prev) {
             if (ll->value) dispose(ll->value);
-            free(ll);
+            _LE_Free(ll);
         }
         else ll->next = NULL;
         ll = next;
@@ -49,7 +50,7 @@ void LE_LL_DeepClear(void* list, void(*dispose)(void*)) {
 void* LE_LL_Add(void* list, void* value) {
     struct LinkedList_void* ll = list;
     while (ll->next) ll = ll->next;
-    struct LinkedList_void* entry = malloc(sizeof(struct LinkedList_void));
+    struct LinkedList_void* entry = _LE_Malloc(sizeof(struct LinkedList_void), LE_MemoryTag_List);
     ll->next = entry;
     entry->next = NULL;
     entry->prev = ll;
@@ -64,7 +65,7 @@ void LE_LL_Remove(void* list, void* value) {
         if (ll->value == value) {
             struct LinkedList_void* next = ll->next;
             struct LinkedList_void* prev = ll->prev;
-            free(ll);
+            _LE_Free(ll);
             if (next) next->prev = prev;
             if (prev) prev->next = next;
             ll = next;
@@ -0,0 +1,234 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lunarengine.h"
+#include "memory.h"
+
+typedef struct _LE_LoadJob {
+    LoadJobCallback callback;
+    LoadJobDestructor destructor;
+    void* userdata;
+    void* result;
+    LE_LoadStatus status;
+    float progress;
+    bool cancelled;
+    bool taken;
+    struct _LE_Loader* loader;
+    struct _LE_LoadJob* next;
+    struct _LE_LoadJob* prevOwned;
+    struct _LE_LoadJob* nextOwned;
+} _LE_LoadJob;
+
+typedef struct _LE_Loader {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool shutdown;
+    _LE_LoadJob* running;
+    _LE_LoadJob* pendingHead;
+    _LE_LoadJob* pendingTail;
+    _LE_LoadJob* doneHead;
+    _LE_LoadJob* doneTail;
+    _LE_LoadJob* owned;
+} _LE_Loader;
+
+static void _LE_LoaderPush(_LE_LoadJob** head, _LE_LoadJob** tail, _LE_LoadJob* job) {
+    job->next = NULL;
+    if (*tail) (*tail)->next = job;
+    else *head = job;
+    *tail = job;
+}
+
+static _LE_LoadJob* _LE_LoaderPop(_LE_LoadJob** head, _LE_LoadJob** tail) {
+    _LE_LoadJob* job = *head;
+    if (!job) return NULL;
+    *head = job->next;
+    if (!*head) *tail = NULL;
+    job->next = NULL;
+    return job;
+}
+
+static void _LE_LoaderUnlink(_LE_LoadJob** head, _LE_LoadJob** tail, _LE_LoadJob* job) {
+    _LE_LoadJob* prev = NULL;
+    for (_LE_LoadJob* curr = *head; curr; prev = curr, curr = curr->next) {
+        if (curr != job) continue;
+        if (prev) prev->next = curr->next;
+        else *head = curr->next;
+        if (*tail == curr) *tail = prev;
+        curr->next = NULL;
+        return;
+    }
+}
+
+static void _LE_LoaderDisown(_LE_Loader* loader, _LE_LoadJob* job) {
+    if (job->prevOwned) job->prevOwned->nextOwned = job->nextOwned;
+    else loader->owned = job->nextOwned;
+    if (job->nextOwned) job->nextOwned->prevOwned = job->prevOwned;
+}
+
+static void _LE_LoadJobFree(_LE_LoadJob* job) {
+    if (job->destructor && job->result && !job->taken) job->destructor(job->result, job->userdata);
+    _LE_Free(job);
+}
+
+static void _LE_LoaderFinish(_LE_Loader* loader, _LE_LoadJob* job, LE_LoadStatus status) {
+    job->status = status;
+    _LE_LoaderPush(&loader->doneHead, &loader->doneTail, job);
+    pthread_cond_broadcast(&loader->cond);
+}
+
+static void* _LE_LoaderThread(void* ptr) {
+    _LE_Loader* loader = ptr;
+    pthread_mutex_lock(&loader->lock);
+    while (true) {
+        while (!loader->shutdown && !loader->pendingHead) pthread_cond_wait(&loader->cond, &loader->lock);
+        if (loader->shutdown) break;
+        _LE_LoadJob* job = _LE_LoaderPop(&loader->pendingHead, &loader->pendingTail);
+        job->status = LE_LoadStatus_Running;
+        loader->running = job;
+        pthread_mutex_unlock(&loader->lock);
+        void* result = job->callback((LE_LoadJob*)job, job->userdata);
+        pthread_mutex_lock(&loader->lock);
+        job->result = result;
+        loader->running = NULL;
+        if (!job->cancelled) job->progress = 1;
+        _LE_LoaderFinish(loader, job, job->cancelled ? LE_LoadStatus_Cancelled : LE_LoadStatus_Done);
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+LE_Loader* LE_CreateLoader() {
+    _LE_Loader* loader = _LE_Malloc(sizeof(_LE_Loader), LE_MemoryTag_Jobs);
+    memset(loader, 0, sizeof(_LE_Loader));
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->cond, NULL);
+    pthread_create(&loader->thread, NULL, _LE_LoaderThread, loader);
+    return (LE_Loader*)loader;
+}
+
+LE_LoadJob* LE_LoaderSubmit(LE_Loader* loader, LoadJobCallback callback, LoadJobDestructor destructor, void* userdata) {
+    _LE_Loader* l = (_LE_Loader*)loader;
+    _LE_LoadJob* job = _LE_Malloc(sizeof(_LE_LoadJob), LE_MemoryTag_Jobs);
+    memset(job, 0, sizeof(_LE_LoadJob));
+    job->callback = callback;
+    job->destructor = destructor;
+    job->userdata = userdata;
+    job->status = LE_LoadStatus_Pending;
+    job->loader = l;
+    pthread_mutex_lock(&l->lock);
+    job->nextOwned = l->owned;
+    if (l->owned) l->owned->prevOwned = job;
+    l->owned = job;
+    _LE_LoaderPush(&l->pendingHead, &l->pendingTail, job);
+    pthread_cond_broadcast(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+    return (LE_LoadJob*)job;
+}
+
+LE_LoadJob* LE_LoaderPoll(LE_Loader* loader) {
+    _LE_Loader* l = (_LE_Loader*)loader;
+    pthread_mutex_lock(&l->lock);
+    _LE_LoadJob* job = _LE_LoaderPop(&l->doneHead, &l->doneTail);
+    pthread_mutex_unlock(&l->lock);
+    return (LE_LoadJob*)job;
+}
+
+void LE_LoadJobWait(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    _LE_Loader* l = j->loader;
+    pthread_mutex_lock(&l->lock);
+    while (j->status == LE_LoadStatus_Pending || j->status == LE_LoadStatus_Running) pthread_cond_wait(&l->cond, &l->lock);
+    pthread_mutex_unlock(&l->lock);
+}
+
+void LE_LoadJobCancel(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    _LE_Loader* l = j->loader;
+    pthread_mutex_lock(&l->lock);
+    j->cancelled = true;
+    if (j->status == LE_LoadStatus_Pending) {
+        _LE_LoaderUnlink(&l->pendingHead, &l->pendingTail, j);
+        _LE_LoaderFinish(l, j, LE_LoadStatus_Cancelled);
+    }
+    pthread_mutex_unlock(&l->lock);
+}
+
+bool LE_LoadJobIsCancelled(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    pthread_mutex_lock(&j->loader->lock);
+    bool cancelled = j->cancelled;
+    pthread_mutex_unlock(&j->loader->lock);
+    return cancelled;
+}
+
+void LE_LoadJobSetProgress(LE_LoadJob* job, float progress) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    if (progress < 0) progress = 0;
+    if (progress > 1) progress = 1;
+    pthread_mutex_lock(&j->loader->lock);
+    j->progress = progress;
+    pthread_mutex_unlock(&j->loader->lock);
+}
+
+float LE_LoadJobGetProgress(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    pthread_mutex_lock(&j->loader->lock);
+    float progress = j->progress;
+    pthread_mutex_unlock(&j->loader->lock);
+    return progress;
+}
+
+LE_LoadStatus LE_LoadJobGetStatus(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    pthread_mutex_lock(&j->loader->lock);
+    LE_LoadStatus status = j->status;
+    pthread_mutex_unlock(&j->loader->lock);
+    return status;
+}
+
+void* LE_LoadJobGetResult(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    pthread_mutex_lock(&j->loader->lock);
+    void* result = j->result;
+    if (j->status == LE_LoadStatus_Done || j->status == LE_LoadStatus_Cancelled) j->taken = true;
+    pthread_mutex_unlock(&j->loader->lock);
+    return result;
+}
+
+void LE_DestroyLoadJob(LE_LoadJob* job) {
+    _LE_LoadJob* j = (_LE_LoadJob*)job;
+    _LE_Loader* l = j->loader;
+    pthread_mutex_lock(&l->lock);
+    j->cancelled = true;
+    if (j->status == LE_LoadStatus_Pending) _LE_LoaderUnlink(&l->pendingHead, &l->pendingTail, j);
+    else {
+        while (j->status == LE_LoadStatus_Running) pthread_cond_wait(&l->cond, &l->lock);
+        _LE_LoaderUnlink(&l->doneHead, &l->doneTail, j);
+    }
+    _LE_LoaderDisown(l, j);
+    pthread_mutex_unlock(&l->lock);
+    _LE_LoadJobFree(j);
+}
+
+void LE_DestroyLoader(LE_Loader* loader) {
+    _LE_Loader* l = (_LE_Loader*)loader;
+    pthread_mutex_lock(&l->lock);
+    l->shutdown = true;
+    if (l->running) l->running->cancelled = true;
+    for (_LE_LoadJob* curr = l->pendingHead; curr; curr = curr->next) {
+        curr->cancelled = true;
+    }
+    pthread_cond_broadcast(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+    pthread_join(l->thread, NULL);
+    while (l->owned) {
+        _LE_LoadJob* job = l->owned;
+        l->owned = job->nextOwned;
+        _LE_LoadJobFree(job);
+    }
+    pthread_mutex_destroy(&l->lock);
+    pthread_cond_destroy(&l->cond);
+    _LE_Free(l);
+}
@@ -17,12 +17,22 @@ typedef struct {} LE_LayerList;
 typedef struct {} LE_EntityList;
 typedef struct {} LE_EntityListIter;
 typedef struct {} LE_LayerListIter;
+typedef struct {} LE_Snapshot;
+typedef struct {} LE_World;
+typedef struct {} LE_Server;
+typedef struct {} LE_Recording;
+typedef struct {} LE_Loader;
+typedef struct {} LE_LoadJob;
 
 typedef enum {
     LE_EntityFlags_SolidHitbox      = 1 << 0,
     LE_EntityFlags_ShouldDelete     = 1 << 1,
     LE_EntityFlags_DisableCollision = 1 << 2,
     LE_EntityFlags_OnGround         = 1 << 3,
+    LE_EntityFlags_ThreadSafe       = 1 << 4,
+    LE_EntityFlags_Continuous       = 1 << 5,
+    LE_EntityFlags_Static           = 1 << 6,
+    LE_EntityFlags_Kinematic        = 1 << 7,
 } LE_EntityFlags;
 
 typedef enum {
@@ -38,6 +48,25 @@ typedef enum {
     LE_LayerType_Custom
 } LE_LayerType;
 
+typedef enum {
+    LE_ContactPhase_Begin,
+    LE_ContactPhase_Persist,
+    LE_ContactPhase_End
+} LE_ContactPhase;
+
+typedef enum {
+    LE_DrawListFormat_Full,
+    LE_DrawListFormat_Packed,
+    LE_DrawListFormat_Quantized
+} LE_DrawListFormat;
+
+typedef enum {
+    LE_LoadStatus_Pending,
+    LE_LoadStatus_Running,
+    LE_LoadStatus_Done,
+    LE_LoadStatus_Cancelled
+} LE_LoadStatus;
+
 typedef union LE_EntityProperty {
     int asInt;
     bool asBool;
@@ -53,6 +82,66 @@ typedef struct {
     LE_EntityFlags flags;
 } LE_Entity;
 
+typedef struct {
+    int x, y;
+} LE_TileCoord;
+
+typedef struct {
+    LE_Entity* entity;
+    int tileX, tileY;
+    float distance;
+    float hitX, hitY;
+    LE_Direction direction;
+} LE_RaycastHit;
+
+typedef enum {
+    LE_MemoryTag_General,
+    LE_MemoryTag_List,
+    LE_MemoryTag_Entity,
+    LE_MemoryTag_Property,
+    LE_MemoryTag_Collision,
+    LE_MemoryTag_Spatial,
+    LE_MemoryTag_Tile,
+    LE_MemoryTag_Layer,
+    LE_MemoryTag_DrawList,
+    LE_MemoryTag_Snapshot,
+    LE_MemoryTag_Recording,
+    LE_MemoryTag_World,
+    LE_MemoryTag_Jobs,
+    LE_MemoryTag_Profile,
+    LE_MemoryTag_Arena,
+    LE_MemoryTag_Count
+} LE_MemoryTag;
+
+typedef struct {
+    size_t bytes[LE_MemoryTag_Count];
+    size_t peak[LE_MemoryTag_Count];
+    size_t allocations[LE_MemoryTag_Count];
+    size_t totalBytes;
+    size_t totalPeak;
+    size_t frameArenaUsed;
+    size_t frameArenaPeak;
+    size_t frameArenaCapacity;
+} LE_MemoryStats;
+
+#define LE_PROFILE_MAX_LAYERS 16
+#define LE_REPLAY_INCOMPATIBLE -2
+
+typedef struct {
+    bool enabled;
+    float updateEntities;
+    float updateCallbacks;
+    float tileCollision;
+    float entityCollision;
+    float drawLayers;
+    float render;
+    float layers[LE_PROFILE_MAX_LAYERS];
+    unsigned long long entitiesUpdated;
+    unsigned long long pairTests;
+    unsigned long long tileLookups;
+    unsigned long long quadsEmitted;
+} LE_FrameStats;
+
 typedef struct {
     float scrollOffsetX, scrollSpeedX;
     float scrollOffsetY, scrollSpeedY;
@@ -69,13 +158,28 @@ typedef void*(*EntityTextureCallback)(
     int* srcX, int* srcY, int* srcW, int* srcH
 );
 typedef void(*EntityUpdateCallback)(LE_Entity* entity);
+typedef void(*EntityBatchUpdateCallback)(LE_Entity** entities, int count);
 typedef void(*EntityCollisionCallback)(LE_Entity* entity, LE_Entity* collider);
+typedef void(*EntityContactCallback)(LE_Entity* entity, LE_Entity* collider, LE_ContactPhase phase);
+typedef bool(*EntityQueryFilter)(LE_Entity* entity, void* userdata);
 typedef int(*TileTextureCallback)(LE_TileData* tile);
 typedef void(*TileCollisionCallback)(
     LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity,
     int tileX, int tileY,
     LE_Direction direction
 );
+typedef void(*TileContactCallback)(
+    LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity,
+    int tileX, int tileY,
+    LE_Direction direction, LE_ContactPhase phase
+);
+typedef void*(*LE_AllocFunc)(size_t size, void* userdata);
+typedef void*(*LE_ReallocFunc)(void* ptr, size_t size, void* userdata);
+typedef void(*LE_FreeFunc)(void* ptr, void* userdata);
+typedef void(*WorldTickCallback)(LE_World* world, void* userdata);
+typedef void*(*LoadJobCallback)(LE_LoadJob* job, void* userdata);
+typedef void(*LoadJobDestructor)(void* result, void* userdata);
+typedef bool(*TileQueryFilter)(LE_TileData* tile, int tileX, int tileY, void* userdata);
 typedef void(*CustomLayer)(
     LE_DrawList* dl, void* params,
     float scrollOffsetX, float scrollOffsetY,
@@ -84,6 +188,9 @@ typedef void(*CustomLayer)(
 
 LE_LayerList* LE_CreateLayerList();
 LE_Layer* LE_AddTilemapLayer(LE_LayerList* layers, LE_Tilemap* tilemap);
+// entity layers only draw entities near the screen, using each sprite's size from its last draw (or the list's largest
+// sprite if it was never drawn); a drawPriority change takes effect once the entity is updated, or on the next draw for
+// an entity created since the last one. LE_EntityLastDrawnPos keeps its old value while the entity is culled
 LE_Layer* LE_AddEntityLayer(LE_LayerList* layers, LE_EntityList* entities);
 LE_Layer* LE_AddCustomLayer(LE_LayerList* layers, CustomLayer callback, void* params);
 LE_Layer* LE_LayerGetByIndex(LE_LayerList* layers, int index);
@@ -95,8 +202,14 @@ void LE_GlobalToLayerSpace(LE_Layer* layer, float in_x, float in_y, float* out_x
 void LE_LayerToGlobalSpace(LE_Layer* layer, float in_x, float in_y, float* out_x, float* out_y);
 LE_LayerType LE_LayerGetType(LE_Layer* layer);
 void* LE_LayerGetDataPointer(LE_Layer* layer);
+void* LE_LayerSetDataPointer(LE_Layer* layer, void* ptr);
 void LE_UpdateLayerList(LE_LayerList* layers);
 void LE_Draw(LE_LayerList* layers, int screenW, int screenH, float interpolation, LE_DrawList* dl);
+void LE_LayerSetThreadSafe(LE_Layer* layer, bool threadSafe);
+void LE_LayerSetRetained(LE_Layer* layer, bool retained);
+void LE_LayerInvalidate(LE_Layer* layer);
+void LE_LayerGetCacheStats(LE_Layer* layer, int* hits, int* misses);
+void LE_LayerListSetParallelDraw(LE_LayerList* layers, bool parallel);
 void LE_DrawSingleLayer(LE_Layer* layer, int screenW, int screenH, float interpolation, LE_DrawList* dl);
 void LE_DestroyLayer(LE_Layer* layer);
 void LE_DestroyLayerList(LE_LayerList* layers);
@@ -109,6 +222,12 @@ LE_Layer* LE_LayerListGet(LE_LayerListIter* iter);
 LE_DrawList* LE_CreateDrawList();
 void LE_Render(LE_DrawList* dl, DrawListRenderer renderer);
 void LE_DrawListAppend(LE_DrawList* dl, void* texture, float dstX, float dstY, float dstW, float dstH, int srcX, int srcY, int srcW, int srcH);
+void LE_DrawListConcat(LE_DrawList* dl, LE_DrawList* other);
+void LE_DrawListSetTransient(LE_DrawList* dl, bool transient);
+// the quantized format stores destination rects in 1/16 pixel steps; entries that don't fall exactly on that grid
+// are stored at full precision instead, so every format renders the same
+void LE_DrawListSetFormat(LE_DrawList* dl, LE_DrawListFormat format);
+LE_DrawListFormat LE_DrawListGetFormat(LE_DrawList* dl);
 void LE_DrawSetColor(LE_DrawList* dl, unsigned int rgba);
 void LE_ClearDrawList(LE_DrawList* dl);
 void LE_DestroyDrawList(LE_DrawList* list);
@@ -118,19 +237,63 @@ unsigned int LE_DrawGetColor(LE_DrawList* dl);
 LE_EntityBuilder* LE_CreateEntityBuilder();
 void LE_EntityBuilderAddTextureCallback(LE_EntityBuilder* builder, EntityTextureCallback callback);
 void LE_EntityBuilderAddUpdateCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback);
+void LE_EntityBuilderAddBatchUpdateCallback(LE_EntityBuilder* builder, EntityBatchUpdateCallback callback);
 void LE_EntityBuilderAddCollisionCallback(LE_EntityBuilder* builder, EntityCollisionCallback callback);
+void LE_EntityBuilderAddContactCallback(LE_EntityBuilder* builder, EntityContactCallback callback);
+void LE_EntityBuilderAddWakeCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback);
+void LE_EntityBuilderAddSleepCallback(LE_EntityBuilder* builder, EntityUpdateCallback callback);
+void LE_EntityBuilderSetAlwaysActive(LE_EntityBuilder* builder, bool alwaysActive);
 void LE_EntityBuilderSetHitboxSize(LE_EntityBuilder* builder, float width, float height);
 void LE_EntityBuilderSetFlags(LE_EntityBuilder* builder, LE_EntityFlags flags);
+void LE_EntityBuilderSetCollisionLayer(LE_EntityBuilder* builder, unsigned int category, unsigned int mask);
 void LE_EntityBuilderAppendFlags(LE_EntityBuilder* builder, LE_EntityFlags flags);
 void LE_EntityBuilderClearFlags(LE_EntityBuilder* builder, LE_EntityFlags flags);
 void LE_EntityBuilderSetProperty(LE_EntityBuilder* builder, LE_EntityProperty property, const char* name);
 void LE_EntityBuilderSetDrawPriority(LE_EntityBuilder* builder, int priority);
+void LE_EntityBuilderSetName(LE_EntityBuilder* builder, const char* name);
+const char* LE_EntityBuilderGetName(LE_EntityBuilder* builder);
+void LE_EntityBuilderSetSpriteCache(LE_EntityBuilder* builder, bool enabled, const char* frameProperty);
 void LE_DestroyEntityBuilder(LE_EntityBuilder* builder);
 
+void LE_SetAllocator(LE_AllocFunc allocFunc, LE_ReallocFunc reallocFunc, LE_FreeFunc freeFunc, void* userdata);
+void LE_GetMemoryStats(LE_MemoryStats* stats);
+void LE_FrameArenaReset();
+
+void LE_SetWorkerThreads(int count);
+int  LE_GetWorkerThreads();
+
+void LE_GetFrameStats(LE_FrameStats* stats);
+void LE_ResetFrameStats();
+void LE_TraceStart(int entitySampleRate);
+void LE_TraceStop();
+bool LE_TraceDump(const char* path);
+
 LE_EntityList* LE_CreateEntityList();
 LE_Entity* LE_CreateEntity(LE_EntityList* list, LE_EntityBuilder* builder, float x, float y);
+void LE_CreateEntities(LE_EntityList* list, LE_EntityBuilder* builder, int count, const float* positions, LE_Entity** out);
+// the spatial grid only picks up a position written straight to posX/posY when the entity is next updated, so dormant
+// entities must be moved with LE_EntitySetPosition or queries, collisions, activation and drawing won't find them there
+void LE_EntitySetPosition(LE_Entity* entity, float x, float y);
 LE_Entity* LE_EntityGetPlatform(LE_Entity* entity);
+void LE_EntitySetCollisionLayer(LE_Entity* entity, unsigned int category, unsigned int mask);
+void LE_EntityGetCollisionLayer(LE_Entity* entity, unsigned int* category, unsigned int* mask);
 void LE_EntityAssignTilemap(LE_EntityList* list, LE_Tilemap* tilemap);
+int  LE_EntityListAddActivationRect(LE_EntityList* list, float x, float y, float w, float h);
+int  LE_EntityListAddCameraActivation(LE_EntityList* list, LE_LayerList* layers, float w, float h);
+void LE_EntityListSetActivationRect(LE_EntityList* list, int region, float x, float y, float w, float h);
+void LE_EntityListRemoveActivationRegion(LE_EntityList* list, int region);
+bool LE_EntityIsDormant(LE_Entity* entity);
+// parallel lists only parallelise update callbacks: with the contact cache enabled, runs of LE_EntityFlags_ThreadSafe
+// entities between non-thread-safe ones have their callbacks run across the worker pool, while integration and collision
+// stay serial; thread-safe callbacks may only touch their own entity (properties, position and deletion included),
+// and results are bit-identical to a serial update
+void LE_EntityListSetParallel(LE_EntityList* list, bool parallel);
+// with the contact cache enabled, collisions are reported only through contact callbacks: the LE_EntityCollision and
+// LE_TileCollisionEvent callbacks stop firing for the list. destroying an entity or moving it to another list ends its
+// contacts on the spot, so End callbacks run from inside LE_DestroyEntity and LE_EntityChangeLists
+void LE_EntityListSetContactCache(LE_EntityList* list, bool enabled);
+void LE_EntityListAddCollisionList(LE_EntityList* list, LE_EntityList* other);
+void LE_EntityListRemoveCollisionList(LE_EntityList* list, LE_EntityList* other);
 void LE_EntitySetProperty(LE_Entity* entity, LE_EntityProperty property, const char* name);
 void LE_EntityDelProperty(LE_Entity* entity, const char* name);
 bool LE_EntityGetProperty(LE_Entity* entity, LE_EntityProperty* property, const char* name);
@@ -138,10 +301,12 @@ int  LE_EntityNumProperties(LE_Entity* entity);
 LE_EntityProperty LE_EntityGetPropertyOrDefault(LE_Entity* entity, LE_EntityProperty def, const char* name);
 const char* LE_EntityGetPropertyKey(LE_Entity* entity, int index);
 void LE_EntityChangeLists(LE_Entity* entity, LE_EntityList* destlist);
+void LE_EntitiesChangeLists(LE_Entity** entities, int count, LE_EntityList* destlist);
 void LE_EntityCollision(LE_Entity* entity, LE_Entity* collider);
 void LE_UpdateEntities(LE_EntityList* list, float delta_time);
 void LE_UpdateEntity(LE_Entity* entity, float delta_time);
 void LE_DrawEntity(LE_Entity* entity, float x, float y, float scaleW, float scaleH, LE_DrawList* dl);
+void LE_EntityInvalidateSprite(LE_Entity* entity);
 void LE_EntityLastDrawnPos(LE_Entity* entity, float* x, float* y);
 bool LE_EntityIsDeleted(LE_Entity* entity);
 void LE_DeleteEntity(LE_Entity* entity);
@@ -154,10 +319,18 @@ LE_EntityListIter* LE_EntityListGetIter(LE_EntityList* list);
 LE_EntityListIter* LE_EntityListNext(LE_EntityListIter* iter);
 LE_EntityListIter* LE_EntityListPrev(LE_EntityListIter* iter);
 LE_Entity* LE_EntityListGet(LE_EntityListIter* iter);
+unsigned int LE_EntityGetHandle(LE_Entity* entity);
+LE_Entity* LE_EntityFromHandle(LE_EntityList* list, unsigned int handle);
+int  LE_EntityListQueryRect(LE_EntityList* list, float x1, float y1, float x2, float y2, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max);
+int  LE_EntityListQueryPoint(LE_EntityList* list, float x, float y, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max);
+int  LE_EntityListQueryRadius(LE_EntityList* list, float x, float y, float radius, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max);
+int  LE_EntityListRaycast(LE_EntityList* list, float x, float y, float dirX, float dirY, float maxDistance, EntityQueryFilter filter, void* userdata, LE_RaycastHit* out, int max);
 
 LE_TileData* LE_CreateTileData();
 void LE_TileAddTextureCallback(LE_TileData* tile, TileTextureCallback callback);
 void LE_TileAddCollisionCallback(LE_TileData* tile, TileCollisionCallback callback);
+void LE_TileAddContactCallback(LE_TileData* tile, TileContactCallback callback);
+void LE_TileContactEvent(LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity, int tileX, int tileY, LE_Direction direction, LE_ContactPhase phase);
 void LE_TileCollisionEvent(LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity, int tileX, int tileY, LE_Direction direction);
 void LE_TileSetSolid(LE_TileData* tile, bool solid);
 void LE_DrawTileAt(LE_TileData* tile, LE_Tileset* tileset, float x, float y, float scaleW, float scaleH, LE_DrawList* dl);
@@ -181,8 +354,87 @@ int  LE_TilemapGetTile(LE_Tilemap* tilemap, int x, int y);
 LE_TileData* LE_TilemapGetTileData(LE_Tilemap* tilemap, int x, int y);
 LE_Tileset * LE_TilemapGetTileset (LE_Tilemap* tilemap);
 void LE_TilemapSetRepeating(LE_Tilemap* tilemap, bool repeating);
+int  LE_TilemapQueryRect(LE_Tilemap* tilemap, float x1, float y1, float x2, float y2, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max);
+int  LE_TilemapQueryPoint(LE_Tilemap* tilemap, float x, float y, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max);
+int  LE_TilemapQueryRadius(LE_Tilemap* tilemap, float x, float y, float radius, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max);
+int  LE_TilemapRaycast(LE_Tilemap* tilemap, float x, float y, float dirX, float dirY, float maxDistance, TileQueryFilter filter, void* userdata, LE_RaycastHit* out, int max);
 void LE_DrawWholeTilemap(LE_Tilemap* tilemap, float x, float y, float scaleW, float scaleH, LE_DrawList* dl);
 void LE_DrawPartialTilemap(LE_Tilemap* tilemap, float x, float y, int fromX, int fromY, int toX, int toY, float scaleW, float scaleH, LE_DrawList* dl);
 void LE_DestroyTilemap(LE_Tilemap* tilemap);
 
+LE_World* LE_CreateWorld(LE_LayerList* layers);
+void LE_WorldAddEntityList(LE_World* world, LE_EntityList* list);
+void LE_WorldRemoveEntityList(LE_World* world, LE_EntityList* list);
+void LE_WorldReplaceEntityList(LE_World* world, LE_EntityList* list, LE_EntityList* replacement);
+LE_LayerList* LE_WorldGetLayers(LE_World* world);
+void LE_WorldSetTickLength(LE_World* world, float seconds);
+void LE_WorldSetTickDelta(LE_World* world, float delta);
+void LE_WorldSetMaxCatchUp(LE_World* world, int ticks);
+void LE_WorldSetTickCallback(LE_World* world, WorldTickCallback callback, void* userdata);
+void LE_WorldSetPipelined(LE_World* world, bool pipelined);
+int  LE_WorldAdvance(LE_World* world, float seconds);
+int  LE_WorldFrame(LE_World* world, float seconds, int screenW, int screenH, LE_DrawList* dl);
+void LE_WorldSync(LE_World* world);
+float LE_WorldGetInterpolation(LE_World* world);
+unsigned long long LE_WorldGetTicks(LE_World* world);
+int  LE_WorldGetDroppedTicks(LE_World* world);
+float LE_WorldGetTickCost(LE_World* world, float* last);
+void LE_DestroyWorld(LE_World* world);
+
+LE_Server* LE_CreateServer();
+void LE_ServerAddWorld(LE_Server* server, LE_World* world);
+void LE_ServerRemoveWorld(LE_Server* server, LE_World* world);
+int  LE_ServerNumWorlds(LE_Server* server);
+LE_World* LE_ServerGetWorld(LE_Server* server, int index);
+int  LE_ServerAdvance(LE_Server* server, float seconds);
+void LE_ServerTick(LE_Server* server);
+float LE_ServerGetTickCost(LE_Server* server);
+void LE_DestroyServer(LE_Server* server);
+
+LE_Snapshot* LE_CreateSnapshot();
+void LE_SnapshotCapture(LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers);
+void LE_SnapshotCaptureDelta(LE_Snapshot* snapshot, LE_Snapshot* base, LE_EntityList* list, LE_LayerList* layers);
+// restoring fails when the snapshot's tiles are out of range for the list's tileset. a list last captured or restored
+// against the same full snapshot only rewrites the entities and tiles changed since, so dormant entities must be
+// modified through the API rather than by writing their fields for the restore to see the change
+bool LE_SnapshotRestore(LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers);
+// snapshot data refers to builders and entity lists by creation order and to tiles by tileset index, so the loading
+// side must create them in the same order; loading rejects data that is truncated, inconsistent or names unknown builders
+const void* LE_SnapshotGetData(LE_Snapshot* snapshot, int* size);
+bool LE_SnapshotLoad(LE_Snapshot* snapshot, LE_Snapshot* base, const void* data, int size);
+int  LE_SnapshotSize(LE_Snapshot* snapshot);
+bool LE_SnapshotIsDelta(LE_Snapshot* snapshot);
+void LE_DestroySnapshot(LE_Snapshot* snapshot);
+
+LE_Recording* LE_CreateRecording();
+void LE_RecordingSetHashInterval(LE_Recording* recording, int ticks);
+void LE_RecordingStart(LE_Recording* recording, LE_World* world);
+void LE_RecordingStop(LE_Recording* recording);
+int  LE_RecordingNumTicks(LE_Recording* recording);
+int  LE_RecordingSize(LE_Recording* recording);
+// replaying returns -1 when every hashed tick matched, the first tick that didn't otherwise, or LE_REPLAY_INCOMPATIBLE
+// when the world has a different number of entity lists than the recording
+int  LE_RecordingReplay(LE_Recording* recording, LE_World* world);
+// recording data stores its initial snapshots and names builders by id, so it loads under the same rules as snapshot data
+const void* LE_RecordingGetData(LE_Recording* recording, int* size);
+bool LE_RecordingLoad(LE_Recording* recording, const void* data, int size);
+void LE_DestroyRecording(LE_Recording* recording);
+
+// a job belongs to its loader until LE_DestroyLoadJob, which unlinks it from the loader's queues
+// (cancelling and waiting for it if unfinished); LE_DestroyLoader destroys every job not yet destroyed, including
+// ones already returned by LE_LoaderPoll. a destroyed job whose result was never read with LE_LoadJobGetResult
+// (such as a cancelled one) passes the result to the destructor, which may be NULL
+LE_Loader* LE_CreateLoader();
+LE_LoadJob* LE_LoaderSubmit(LE_Loader* loader, LoadJobCallback callback, LoadJobDestructor destructor, void* userdata);
+LE_LoadJob* LE_LoaderPoll(LE_Loader* loader);
+void LE_LoadJobWait(LE_LoadJob* job);
+void LE_LoadJobCancel(LE_LoadJob* job);
+bool LE_LoadJobIsCancelled(LE_LoadJob* job);
+void LE_LoadJobSetProgress(LE_LoadJob* job, float progress);
+float LE_LoadJobGetProgress(LE_LoadJob* job);
+LE_LoadStatus LE_LoadJobGetStatus(LE_LoadJob* job);
+void* LE_LoadJobGetResult(LE_LoadJob* job);
+void LE_DestroyLoadJob(LE_LoadJob* job);
+void LE_DestroyLoader(LE_Loader* loader);
+
 #endif
\ No newline at end of file
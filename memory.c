@@ -0,0 +1,214 @@
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lunarengine.h"
+#include "memory.h"
+
+typedef union {
+    struct {
+        size_t size;
+        LE_MemoryTag tag;
+    };
+    max_align_t align;
+} _LE_AllocHeader;
+
+typedef struct _LE_ArenaBlock {
+    struct _LE_ArenaBlock* next;
+    size_t capacity;
+    atomic_size_t used;
+    alignas(max_align_t) char data[];
+} _LE_ArenaBlock;
+
+static void* _LE_DefaultAlloc(size_t size, void* userdata) {
+    return malloc(size);
+}
+
+static void* _LE_DefaultRealloc(void* ptr, size_t size, void* userdata) {
+    return realloc(ptr, size);
+}
+
+static void _LE_DefaultFree(void* ptr, void* userdata) {
+    free(ptr);
+}
+
+static struct {
+    LE_AllocFunc alloc;
+    LE_ReallocFunc realloc;
+    LE_FreeFunc free;
+    void* userdata;
+    atomic_size_t bytes[LE_MemoryTag_Count];
+    atomic_size_t peak[LE_MemoryTag_Count];
+    atomic_size_t allocations[LE_MemoryTag_Count];
+    atomic_size_t totalBytes;
+    atomic_size_t totalPeak;
+} allocator = { _LE_DefaultAlloc, _LE_DefaultRealloc, _LE_DefaultFree, NULL };
+
+static struct {
+    _LE_ArenaBlock* _Atomic current;
+    _LE_ArenaBlock* blocks;
+    size_t retired, capacity;
+    pthread_mutex_t lock;
+    atomic_uint generation;
+    size_t peak;
+} arena = { .lock = PTHREAD_MUTEX_INITIALIZER, .generation = 1 };
+
+static void _LE_RaisePeak(atomic_size_t* peak, size_t value) {
+    size_t curr = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > curr && !atomic_compare_exchange_weak_explicit(peak, &curr, value, memory_order_relaxed, memory_order_relaxed));
+}
+
+static void _LE_Track(LE_MemoryTag tag, size_t size, bool add) {
+    if (add) {
+        size_t bytes = atomic_fetch_add_explicit(&allocator.bytes[tag], size, memory_order_relaxed) + size;
+        size_t total = atomic_fetch_add_explicit(&allocator.totalBytes, size, memory_order_relaxed) + size;
+        atomic_fetch_add_explicit(&allocator.allocations[tag], 1, memory_order_relaxed);
+        _LE_RaisePeak(&allocator.peak[tag], bytes);
+        _LE_RaisePeak(&allocator.totalPeak, total);
+    }
+    else {
+        atomic_fetch_sub_explicit(&allocator.bytes[tag], size, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&allocator.totalBytes, size, memory_order_relaxed);
+        atomic_fetch_sub_explicit(&allocator.allocations[tag], 1, memory_order_relaxed);
+    }
+}
+
+void LE_SetAllocator(LE_AllocFunc allocFunc, LE_ReallocFunc reallocFunc, LE_FreeFunc freeFunc, void* userdata) {
+    bool custom = allocFunc && freeFunc;
+    allocator.alloc = custom ? allocFunc : _LE_DefaultAlloc;
+    allocator.realloc = custom ? reallocFunc : _LE_DefaultRealloc;
+    allocator.free = custom ? freeFunc : _LE_DefaultFree;
+    allocator.userdata = custom ? userdata : NULL;
+}
+
+void* _LE_Malloc(size_t size, LE_MemoryTag tag) {
+    _LE_AllocHeader* header = allocator.alloc(sizeof(_LE_AllocHeader) + size, allocator.userdata);
+    if (!header) return NULL;
+    header->size = size;
+    header->tag = tag;
+    _LE_Track(tag, size, true);
+    return header + 1;
+}
+
+void* _LE_Calloc(size_t count, size_t size, LE_MemoryTag tag) {
+    void* ptr = _LE_Malloc(count * size, tag);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* _LE_Realloc(void* ptr, size_t size, LE_MemoryTag tag) {
+    if (!ptr) return _LE_Malloc(size, tag);
+    _LE_AllocHeader* header = (_LE_AllocHeader*)ptr - 1;
+    size_t oldSize = header->size;
+    tag = header->tag;
+    _LE_AllocHeader* resized;
+    if (allocator.realloc) resized = allocator.realloc(header, sizeof(_LE_AllocHeader) + size, allocator.userdata);
+    else {
+        resized = allocator.alloc(sizeof(_LE_AllocHeader) + size, allocator.userdata);
+        if (resized) {
+            memcpy(resized, header, sizeof(_LE_AllocHeader) + (oldSize < size ? oldSize : size));
+            allocator.free(header, allocator.userdata);
+        }
+    }
+    if (!resized) return NULL;
+    resized->size = size;
+    _LE_Track(tag, oldSize, false);
+    _LE_Track(tag, size, true);
+    return resized + 1;
+}
+
+char* _LE_Strdup(const char* str, LE_MemoryTag tag) {
+    size_t length = strlen(str) + 1;
+    char* copy = _LE_Malloc(length, tag);
+    if (copy) memcpy(copy, str, length);
+    return copy;
+}
+
+void _LE_Free(void* ptr) {
+    if (!ptr) return;
+    _LE_AllocHeader* header = (_LE_AllocHeader*)ptr - 1;
+    _LE_Track(header->tag, header->size, false);
+    allocator.free(header, allocator.userdata);
+}
+
+static size_t _LE_ArenaBlockUsed(_LE_ArenaBlock* block) {
+    if (!block) return 0;
+    size_t used = atomic_load_explicit(&block->used, memory_order_relaxed);
+    return used < block->capacity ? used : block->capacity;
+}
+
+void* _LE_FrameAlloc(size_t size) {
+    size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    while (true) {
+        _LE_ArenaBlock* block = atomic_load_explicit(&arena.current, memory_order_acquire);
+        if (block) {
+            size_t offset = atomic_fetch_add_explicit(&block->used, size, memory_order_relaxed);
+            if (offset + size <= block->capacity) return block->data + offset;
+        }
+        pthread_mutex_lock(&arena.lock);
+        if (atomic_load_explicit(&arena.current, memory_order_relaxed) == block) {
+            size_t capacity = block ? block->capacity * 2 : 64 * 1024;
+            while (capacity < size) capacity *= 2;
+            _LE_ArenaBlock* next = _LE_Malloc(sizeof(_LE_ArenaBlock) + capacity, LE_MemoryTag_Arena);
+            if (!next) {
+                pthread_mutex_unlock(&arena.lock);
+                return NULL;
+            }
+            arena.retired += _LE_ArenaBlockUsed(block);
+            arena.capacity += capacity;
+            next->next = arena.blocks;
+            next->capacity = capacity;
+            atomic_init(&next->used, 0);
+            arena.blocks = next;
+            atomic_store_explicit(&arena.current, next, memory_order_release);
+        }
+        pthread_mutex_unlock(&arena.lock);
+    }
+}
+
+unsigned int _LE_FrameGeneration() {
+    return atomic_load_explicit(&arena.generation, memory_order_acquire);
+}
+
+void LE_FrameArenaReset() {
+    pthread_mutex_lock(&arena.lock);
+    size_t used = arena.retired + _LE_ArenaBlockUsed(arena.blocks);
+    if (used > arena.peak) arena.peak = used;
+    arena.retired = 0;
+    if (arena.blocks && arena.blocks->next) {
+        _LE_ArenaBlock* merged = _LE_Malloc(sizeof(_LE_ArenaBlock) + arena.capacity, LE_MemoryTag_Arena);
+        if (merged) {
+            while (arena.blocks) {
+                _LE_ArenaBlock* next = arena.blocks->next;
+                _LE_Free(arena.blocks);
+                arena.blocks = next;
+            }
+            merged->next = NULL;
+            merged->capacity = arena.capacity;
+            atomic_init(&merged->used, 0);
+            arena.blocks = merged;
+            atomic_store_explicit(&arena.current, merged, memory_order_release);
+        }
+    }
+    if (arena.blocks) atomic_store_explicit(&arena.blocks->used, 0, memory_order_relaxed);
+    atomic_fetch_add_explicit(&arena.generation, 1, memory_order_release);
+    pthread_mutex_unlock(&arena.lock);
+}
+
+void LE_GetMemoryStats(LE_MemoryStats* stats) {
+    memset(stats, 0, sizeof(LE_MemoryStats));
+    for (int i = 0; i < LE_MemoryTag_Count; i++) {
+        stats->bytes[i]       = atomic_load_explicit(&allocator.bytes[i], memory_order_relaxed);
+        stats->peak[i]        = atomic_load_explicit(&allocator.peak[i], memory_order_relaxed);
+        stats->allocations[i] = atomic_load_explicit(&allocator.allocations[i], memory_order_relaxed);
+    }
+    stats->totalBytes = atomic_load_explicit(&allocator.totalBytes, memory_order_relaxed);
+    stats->totalPeak  = atomic_load_explicit(&allocator.totalPeak, memory_order_relaxed);
+    pthread_mutex_lock(&arena.lock);
+    stats->frameArenaUsed = arena.retired + _LE_ArenaBlockUsed(arena.blocks);
+    stats->frameArenaCapacity = arena.capacity;
+    stats->frameArenaPeak = arena.peak > stats->frameArenaUsed ? arena.peak : stats->frameArenaUsed;
+    pthread_mutex_unlock(&arena.lock);
+}
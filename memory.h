@@ -0,0 +1,17 @@
+#ifndef LUNAR_ENGINE_MEMORY_H
+#define LUNAR_ENGINE_MEMORY_H
+
+#include <stddef.h>
+
+#include "lunarengine.h"
+
+void* _LE_Malloc(size_t size, LE_MemoryTag tag);
+void* _LE_Calloc(size_t count, size_t size, LE_MemoryTag tag);
+void* _LE_Realloc(void* ptr, size_t size, LE_MemoryTag tag);
+char* _LE_Strdup(const char* str, LE_MemoryTag tag);
+void  _LE_Free(void* ptr);
+
+void* _LE_FrameAlloc(size_t size);
+unsigned int _LE_FrameGeneration();
+
+#endif
@@ -0,0 +1,247 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "entity.h"
+#include "lunarengine.h"
+#include "memory.h"
+#include "profile.h"
+
+#ifdef LE_PROFILING
+
+#define LE_TRACE_CAPACITY (1 << 15)
+
+typedef struct {
+    unsigned long long start, duration;
+    _LE_Zone zone;
+    int layer;
+    unsigned int entity;
+    char builder[32];
+} _LE_TraceEvent;
+
+typedef struct _LE_ProfileBlock {
+    atomic_ullong zones[_LE_Zone_Count];
+    atomic_ullong layers[LE_PROFILE_MAX_LAYERS];
+    atomic_ullong counters[_LE_Counter_Count];
+    _LE_TraceEvent* events;
+    atomic_ullong head;
+    unsigned int sample;
+    int tid;
+    struct _LE_ProfileBlock* next;
+} _LE_ProfileBlock;
+
+static const char* zoneNames[_LE_Zone_Count] = {
+    [_LE_Zone_UpdateEntities]  = "LE_UpdateEntities",
+    [_LE_Zone_UpdateCallbacks] = "UpdateCallbacks",
+    [_LE_Zone_TileCollision]   = "TileCollision",
+    [_LE_Zone_EntityCollision] = "EntityCollision",
+    [_LE_Zone_DrawLayer]       = "LE_DrawSingleLayer",
+    [_LE_Zone_Render]          = "LE_Render",
+};
+
+static pthread_mutex_t profileLock = PTHREAD_MUTEX_INITIALIZER;
+static _LE_ProfileBlock* profileBlocks = NULL;
+static int numProfileBlocks = 0;
+static _Thread_local _LE_ProfileBlock* localBlock = NULL;
+static atomic_bool tracing = false;
+static atomic_int traceSampleRate = 0;
+static unsigned long long traceEpoch = 0;
+
+static _LE_ProfileBlock* _LE_ProfileLocal() {
+    if (localBlock) return localBlock;
+    localBlock = _LE_Malloc(sizeof(_LE_ProfileBlock), LE_MemoryTag_Profile);
+    memset(localBlock, 0, sizeof(_LE_ProfileBlock));
+    pthread_mutex_lock(&profileLock);
+    localBlock->tid = ++numProfileBlocks;
+    localBlock->next = profileBlocks;
+    profileBlocks = localBlock;
+    pthread_mutex_unlock(&profileLock);
+    return localBlock;
+}
+
+static _LE_TraceEvent* _LE_TraceReserve(_LE_ProfileBlock* block) {
+    if (!block->events) block->events = _LE_Malloc(sizeof(_LE_TraceEvent) * LE_TRACE_CAPACITY, LE_MemoryTag_Profile);
+    unsigned long long head = atomic_load_explicit(&block->head, memory_order_relaxed);
+    return &block->events[head & (LE_TRACE_CAPACITY - 1)];
+}
+
+static void _LE_TraceCommit(_LE_ProfileBlock* block) {
+    atomic_store_explicit(&block->head, atomic_load_explicit(&block->head, memory_order_relaxed) + 1, memory_order_release);
+}
+
+static void _LE_TraceRecord(_LE_ProfileBlock* block, _LE_Zone zone, unsigned long long start, unsigned long long end, int layer, _LE_Entity* entity) {
+    _LE_TraceEvent* event = _LE_TraceReserve(block);
+    event->start = start;
+    event->duration = end - start;
+    event->zone = zone;
+    event->layer = layer;
+    event->entity = entity ? entity->handle : 0;
+    event->builder[0] = 0;
+    if (entity && entity->builder->name) snprintf(event->builder, sizeof(event->builder), "%s", entity->builder->name);
+    else if (entity) snprintf(event->builder, sizeof(event->builder), "builder@%p", (void*)entity->builder);
+    _LE_TraceCommit(block);
+}
+
+static void _LE_ProfileAdd(atomic_ullong* slot, unsigned long long amount) {
+    atomic_fetch_add_explicit(slot, amount, memory_order_relaxed);
+}
+
+unsigned long long _LE_ProfileNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void _LE_ProfileZone(_LE_Zone zone, unsigned long long start) {
+    unsigned long long end = _LE_ProfileNow();
+    _LE_ProfileBlock* block = _LE_ProfileLocal();
+    _LE_ProfileAdd(&block->zones[zone], end - start);
+    if (atomic_load_explicit(&tracing, memory_order_relaxed)) _LE_TraceRecord(block, zone, start, end, -1, NULL);
+}
+
+void _LE_ProfileLayer(LE_Layer* layer, unsigned long long start) {
+    unsigned long long end = _LE_ProfileNow();
+    _LE_ProfileBlock* block = _LE_ProfileLocal();
+    _LE_ProfileAdd(&block->zones[_LE_Zone_DrawLayer], end - start);
+    int index = LE_IndexOfLayer(layer);
+    if (index >= 0 && index < LE_PROFILE_MAX_LAYERS) _LE_ProfileAdd(&block->layers[index], end - start);
+    if (atomic_load_explicit(&tracing, memory_order_relaxed)) _LE_TraceRecord(block, _LE_Zone_DrawLayer, start, end, index, NULL);
+}
+
+void _LE_ProfileEntity(_LE_Zone zone, unsigned long long start, LE_Entity* entity) {
+    unsigned long long end = _LE_ProfileNow();
+    _LE_ProfileBlock* block = _LE_ProfileLocal();
+    _LE_ProfileAdd(&block->zones[zone], end - start);
+    if (!atomic_load_explicit(&tracing, memory_order_relaxed)) return;
+    int rate = atomic_load_explicit(&traceSampleRate, memory_order_relaxed);
+    if (rate <= 0 || block->sample++ % rate != 0) return;
+    _LE_TraceRecord(block, zone, start, end, -1, (_LE_Entity*)entity);
+}
+
+static void _LE_TraceWriteString(FILE* file, const char* str) {
+    fputc('"', file);
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (c == '"' || c == '\\') fprintf(file, "\\%c", c);
+        else if (c < 0x20) fprintf(file, "\\u%04x", c);
+        else fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+static void _LE_TraceWriteEvent(FILE* file, _LE_TraceEvent* event, int tid, bool* first) {
+    fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"lunarengine\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+        *first ? "" : ",", zoneNames[event->zone], tid,
+        (event->start - traceEpoch) / 1e3, event->duration / 1e3
+    );
+    *first = false;
+    if (event->layer >= 0) fprintf(file, ",\"args\":{\"layer\":%d}", event->layer);
+    else if (event->builder[0]) {
+        fprintf(file, ",\"args\":{\"builder\":");
+        _LE_TraceWriteString(file, event->builder);
+        fprintf(file, ",\"entity\":%u}", event->entity);
+    }
+    fputc('}', file);
+}
+
+void _LE_ProfileCount(_LE_Counter counter, unsigned long long amount) {
+    _LE_ProfileAdd(&_LE_ProfileLocal()->counters[counter], amount);
+}
+
+#endif
+
+void LE_GetFrameStats(LE_FrameStats* stats) {
+    memset(stats, 0, sizeof(LE_FrameStats));
+#ifdef LE_PROFILING
+    unsigned long long zones[_LE_Zone_Count] = {0};
+    unsigned long long layers[LE_PROFILE_MAX_LAYERS] = {0};
+    unsigned long long counters[_LE_Counter_Count] = {0};
+    pthread_mutex_lock(&profileLock);
+    for (_LE_ProfileBlock* block = profileBlocks; block; block = block->next) {
+        for (int i = 0; i < _LE_Zone_Count; i++) zones[i] += atomic_load_explicit(&block->zones[i], memory_order_relaxed);
+        for (int i = 0; i < LE_PROFILE_MAX_LAYERS; i++) layers[i] += atomic_load_explicit(&block->layers[i], memory_order_relaxed);
+        for (int i = 0; i < _LE_Counter_Count; i++) counters[i] += atomic_load_explicit(&block->counters[i], memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&profileLock);
+    stats->enabled = true;
+    stats->updateEntities  = zones[_LE_Zone_UpdateEntities]  / 1e9;
+    stats->updateCallbacks = zones[_LE_Zone_UpdateCallbacks] / 1e9;
+    stats->tileCollision   = zones[_LE_Zone_TileCollision]   / 1e9;
+    stats->entityCollision = zones[_LE_Zone_EntityCollision] / 1e9;
+    stats->drawLayers      = zones[_LE_Zone_DrawLayer]       / 1e9;
+    stats->render          = zones[_LE_Zone_Render]          / 1e9;
+    for (int i = 0; i < LE_PROFILE_MAX_LAYERS; i++) stats->layers[i] = layers[i] / 1e9;
+    stats->entitiesUpdated = counters[_LE_Counter_EntitiesUpdated];
+    stats->pairTests       = counters[_LE_Counter_PairTests];
+    stats->tileLookups     = counters[_LE_Counter_TileLookups];
+    stats->quadsEmitted    = counters[_LE_Counter_QuadsEmitted];
+#endif
+}
+
+void LE_ResetFrameStats() {
+#ifdef LE_PROFILING
+    pthread_mutex_lock(&profileLock);
+    for (_LE_ProfileBlock* block = profileBlocks; block; block = block->next) {
+        for (int i = 0; i < _LE_Zone_Count; i++) atomic_store_explicit(&block->zones[i], 0, memory_order_relaxed);
+        for (int i = 0; i < LE_PROFILE_MAX_LAYERS; i++) atomic_store_explicit(&block->layers[i], 0, memory_order_relaxed);
+        for (int i = 0; i < _LE_Counter_Count; i++) atomic_store_explicit(&block->counters[i], 0, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&profileLock);
+#endif
+}
+
+void LE_TraceStart(int entitySampleRate) {
+#ifdef LE_PROFILING
+    pthread_mutex_lock(&profileLock);
+    traceEpoch = _LE_ProfileNow();
+    pthread_mutex_unlock(&profileLock);
+    atomic_store(&traceSampleRate, entitySampleRate);
+    atomic_store(&tracing, true);
+#else
+    (void)entitySampleRate;
+#endif
+}
+
+void LE_TraceStop() {
+#ifdef LE_PROFILING
+    atomic_store(&tracing, false);
+#endif
+}
+
+bool LE_TraceDump(const char* path) {
+#ifdef LE_PROFILING
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+    _LE_TraceEvent* events = _LE_Malloc(sizeof(_LE_TraceEvent) * LE_TRACE_CAPACITY, LE_MemoryTag_Profile);
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    pthread_mutex_lock(&profileLock);
+    for (_LE_ProfileBlock* block = profileBlocks; block; block = block->next) {
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"lunarengine %d\"}}", first ? "" : ",", block->tid, block->tid);
+        first = false;
+        if (!block->events) continue;
+        unsigned long long head = atomic_load_explicit(&block->head, memory_order_acquire);
+        unsigned long long tail = head > LE_TRACE_CAPACITY ? head - LE_TRACE_CAPACITY : 0;
+        int count = head - tail;
+        for (int i = 0; i < count; i++) {
+            events[i] = block->events[(tail + i) & (LE_TRACE_CAPACITY - 1)];
+        }
+        unsigned long long after = atomic_load_explicit(&block->head, memory_order_acquire);
+        int skip = after > LE_TRACE_CAPACITY && after - LE_TRACE_CAPACITY > tail ? after - LE_TRACE_CAPACITY - tail : 0;
+        for (int i = skip; i < count; i++) {
+            if (events[i].start < traceEpoch) continue;
+            _LE_TraceWriteEvent(file, &events[i], block->tid, &first);
+        }
+    }
+    pthread_mutex_unlock(&profileLock);
+    fprintf(file, "\n]}\n");
+    _LE_Free(events);
+    return fclose(file) == 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
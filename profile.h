@@ -0,0 +1,48 @@
+#ifndef LUNAR_ENGINE_PROFILE_H
+#define LUNAR_ENGINE_PROFILE_H
+
+#include "lunarengine.h"
+
+typedef enum {
+    _LE_Zone_UpdateEntities,
+    _LE_Zone_UpdateCallbacks,
+    _LE_Zone_TileCollision,
+    _LE_Zone_EntityCollision,
+    _LE_Zone_DrawLayer,
+    _LE_Zone_Render,
+    _LE_Zone_Count
+} _LE_Zone;
+
+typedef enum {
+    _LE_Counter_EntitiesUpdated,
+    _LE_Counter_PairTests,
+    _LE_Counter_TileLookups,
+    _LE_Counter_QuadsEmitted,
+    _LE_Counter_Count
+} _LE_Counter;
+
+#ifdef LE_PROFILING
+
+unsigned long long _LE_ProfileNow();
+void _LE_ProfileZone(_LE_Zone zone, unsigned long long start);
+void _LE_ProfileLayer(LE_Layer* layer, unsigned long long start);
+void _LE_ProfileEntity(_LE_Zone zone, unsigned long long start, LE_Entity* entity);
+void _LE_ProfileCount(_LE_Counter counter, unsigned long long amount);
+
+#define LE_PROFILE_BEGIN(name) unsigned long long _LE_ProfileStart_##name = _LE_ProfileNow()
+#define LE_PROFILE_END(name, zone) _LE_ProfileZone(zone, _LE_ProfileStart_##name)
+#define LE_PROFILE_END_LAYER(name, layer) _LE_ProfileLayer(layer, _LE_ProfileStart_##name)
+#define LE_PROFILE_END_ENTITY(name, zone, entity) _LE_ProfileEntity(zone, _LE_ProfileStart_##name, (LE_Entity*)(entity))
+#define LE_PROFILE_COUNT(counter, amount) _LE_ProfileCount(counter, amount)
+
+#else
+
+#define LE_PROFILE_BEGIN(name)
+#define LE_PROFILE_END(name, zone)
+#define LE_PROFILE_END_LAYER(name, layer)
+#define LE_PROFILE_END_ENTITY(name, zone, entity)
+#define LE_PROFILE_COUNT(counter, amount)
+
+#endif
+
+#endif
@@ -0,0 +1,475 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity.h"
+#include "layer.h"
+#include "lunarengine.h"
+#include "memory.h"
+#include "record.h"
+#include "tile.h"
+#include "world.h"
+
+typedef struct {
+    int size;
+    _LE_RecordEventType type;
+    int list;
+    unsigned int handle;
+    union {
+        struct { unsigned int builder; float x, y; } spawn;
+        struct { float x, y; } vector;
+        struct { int x, y, tile; } tile;
+        struct { int list; } move;
+        struct { LE_EntityProperty value; int nameLength; } property;
+        struct { float delta; unsigned char hashed; unsigned long long hash; } update;
+    };
+} _LE_RecordEvent;
+
+typedef struct {
+    unsigned int magic;
+    int numLists;
+    int numTicks;
+    int hashInterval;
+    int size;
+    int snapshotsSize;
+} _LE_RecordHeader;
+
+typedef struct {
+    int size;
+    int reserved;
+} _LE_RecordBlock;
+
+typedef struct _LE_Recording {
+    unsigned char* data;
+    int size, capacity;
+    unsigned char* saved;
+    int savedCapacity;
+    LE_Snapshot** initial;
+    int numLists;
+    _LE_World* world;
+    int internal;
+    int numTicks;
+    int hashInterval;
+    int updateOffset;
+} _LE_Recording;
+
+#define LE_RECORD_MAGIC 0x43524C4C
+#define LE_RECORD_MAX_COORD 1073741824.f
+#define LE_RECORD_ALIGN(x) (((x) + 7) & ~7)
+
+static _LE_RecordEvent* _LE_RecordPush(_LE_Recording* recording, _LE_RecordEventType type, int list, unsigned int handle, int extra) {
+    int size = LE_RECORD_ALIGN(sizeof(_LE_RecordEvent) + extra);
+    if (recording->size + size > recording->capacity) {
+        recording->capacity = recording->capacity ? recording->capacity * 2 : 4096;
+        while (recording->size + size > recording->capacity) recording->capacity *= 2;
+        recording->data = _LE_Realloc(recording->data, recording->capacity, LE_MemoryTag_Recording);
+    }
+    _LE_RecordEvent* event = (_LE_RecordEvent*)(recording->data + recording->size);
+    memset(event, 0, size);
+    event->size = size;
+    event->type = type;
+    event->list = list;
+    event->handle = handle;
+    recording->size += size;
+    return event;
+}
+
+static unsigned long long _LE_RecordMix(unsigned long long hash, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static unsigned long long _LE_RecordHash(_LE_World* world) {
+    unsigned long long hash = 0xCBF29CE484222325ull;
+    if (world->layers) {
+        _LE_LayerList* ll = (_LE_LayerList*)world->layers;
+        hash = _LE_RecordMix(hash, &ll->value->cameraData.camPosX, sizeof(float) * 2);
+    }
+    for (int i = 0; i < world->numLists; i++) {
+        _LE_EntityListData* data = LE_ENTITY_LIST_DATA(world->lists[i]);
+        _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+        hash = _LE_RecordMix(hash, &data->nextHandle, sizeof(unsigned int));
+        if (tilemap) hash = _LE_RecordMix(hash, tilemap->data, sizeof(int) * tilemap->width * tilemap->height);
+        for (_LE_EntityList* curr = ((_LE_EntityList*)world->lists[i])->next; curr; curr = curr->next) {
+            _LE_Entity* entity = curr->value;
+            hash = _LE_RecordMix(hash, &entity->handle, sizeof(unsigned int));
+            hash = _LE_RecordMix(hash, &entity->posX, sizeof(float) * 4);
+            hash = _LE_RecordMix(hash, &entity->flags, sizeof(LE_EntityFlags));
+            hash = _LE_RecordMix(hash, &entity->deleted, sizeof(bool));
+            hash = _LE_RecordMix(hash, &entity->dormant, sizeof(bool));
+            for (_LE_EntityPropList* prop = entity->properties->next; prop; prop = prop->next) {
+                hash = _LE_RecordMix(hash, prop->value->name, strlen(prop->value->name));
+                hash = _LE_RecordMix(hash, &prop->value->value, sizeof(LE_EntityProperty));
+            }
+        }
+    }
+    return hash;
+}
+
+static void _LE_RecordSyncVelocities(_LE_Recording* recording, bool record) {
+    _LE_World* world = recording->world;
+    for (int i = 0; i < world->numLists; i++) {
+        for (_LE_EntityList* curr = ((_LE_EntityList*)world->lists[i])->next; curr; curr = curr->next) {
+            _LE_Entity* entity = curr->value;
+            if (entity->velX == entity->recordVelX && entity->velY == entity->recordVelY) continue;
+            if (record) {
+                _LE_RecordEvent* event = _LE_RecordPush(recording, _LE_RecordEvent_Velocity, i, entity->handle, 0);
+                event->vector.x = entity->velX;
+                event->vector.y = entity->velY;
+            }
+            entity->recordVelX = entity->velX;
+            entity->recordVelY = entity->velY;
+        }
+    }
+}
+
+static void _LE_RecordAttach(_LE_Recording* recording, _LE_World* world) {
+    if (world->layers) ((_LE_LayerList*)world->layers)->value->cameraData.recording = recording;
+    for (int i = 0; i < world->numLists; i++) {
+        _LE_EntityListData* data = LE_ENTITY_LIST_DATA(world->lists[i]);
+        _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+        data->recording = recording;
+        data->recordIndex = i;
+        if (tilemap && tilemap->recording != recording) {
+            tilemap->recording = recording;
+            tilemap->recordIndex = i;
+        }
+    }
+    world->recording = recording;
+}
+
+static void _LE_RecordDetach(_LE_World* world) {
+    if (world->layers) ((_LE_LayerList*)world->layers)->value->cameraData.recording = NULL;
+    for (int i = 0; i < world->numLists; i++) {
+        _LE_EntityListData* data = LE_ENTITY_LIST_DATA(world->lists[i]);
+        data->recording = NULL;
+        if (data->tilemap) ((_LE_Tilemap*)data->tilemap)->recording = NULL;
+    }
+    world->recording = NULL;
+}
+
+void _LE_RecordSpawn(_LE_Recording* recording, int list, LE_EntityBuilder* builder, float x, float y) {
+    if (recording->internal) return;
+    _LE_RecordEvent* event = _LE_RecordPush(recording, _LE_RecordEvent_Spawn, list, 0, 0);
+    event->spawn.builder = ((_LE_EntityBuilder*)builder)->id;
+    event->spawn.x = x;
+    event->spawn.y = y;
+}
+
+void _LE_RecordEntity(_LE_Recording* recording, _LE_RecordEventType type, int list, unsigned int handle, float x, float y) {
+    if (recording->internal) return;
+    _LE_RecordEvent* event = _LE_RecordPush(recording, type, list, handle, 0);
+    event->vector.x = x;
+    event->vector.y = y;
+}
+
+void _LE_RecordProperty(_LE_Recording* recording, int list, unsigned int handle, LE_EntityProperty* value, const char* name) {
+    if (recording->internal) return;
+    int nameLength = strlen(name);
+    _LE_RecordEvent* event = _LE_RecordPush(recording, value ? _LE_RecordEvent_SetProperty : _LE_RecordEvent_DelProperty, list, handle, nameLength + 1);
+    if (value) event->property.value = *value;
+    event->property.nameLength = nameLength;
+    memcpy(event + 1, name, nameLength + 1);
+}
+
+void _LE_RecordMove(_LE_Recording* recording, int list, unsigned int handle, int destlist) {
+    if (recording->internal) return;
+    if (destlist < 0) {
+        _LE_RecordPush(recording, _LE_RecordEvent_Destroy, list, handle, 0);
+        return;
+    }
+    _LE_RecordPush(recording, _LE_RecordEvent_Move, list, handle, 0)->move.list = destlist;
+}
+
+void _LE_RecordTile(_LE_Recording* recording, int list, int x, int y, int tile) {
+    if (recording->internal) return;
+    _LE_RecordEvent* event = _LE_RecordPush(recording, _LE_RecordEvent_SetTile, list, 0, 0);
+    event->tile.x = x;
+    event->tile.y = y;
+    event->tile.tile = tile;
+}
+
+void _LE_RecordCamera(_LE_Recording* recording, float x, float y) {
+    if (recording->internal) return;
+    _LE_RecordEvent* event = _LE_RecordPush(recording, _LE_RecordEvent_Camera, -1, 0, 0);
+    event->vector.x = x;
+    event->vector.y = y;
+}
+
+void _LE_RecordTickBegin(_LE_Recording* recording) {
+    _LE_RecordPush(recording, _LE_RecordEvent_Tick, -1, 0, 0);
+}
+
+void _LE_RecordUpdateBegin(_LE_Recording* recording, float delta) {
+    _LE_RecordSyncVelocities(recording, true);
+    recording->updateOffset = recording->size;
+    _LE_RecordPush(recording, _LE_RecordEvent_Update, -1, 0, 0)->update.delta = delta;
+    recording->internal++;
+}
+
+void _LE_RecordUpdateEnd(_LE_Recording* recording) {
+    recording->internal--;
+    _LE_RecordSyncVelocities(recording, false);
+    recording->numTicks++;
+    if (recording->hashInterval <= 0 || recording->numTicks % recording->hashInterval != 0) return;
+    _LE_RecordEvent* event = (_LE_RecordEvent*)(recording->data + recording->updateOffset);
+    event->update.hashed = 1;
+    event->update.hash = _LE_RecordHash(recording->world);
+}
+
+LE_Recording* LE_CreateRecording() {
+    _LE_Recording* recording = _LE_Malloc(sizeof(_LE_Recording), LE_MemoryTag_Recording);
+    memset(recording, 0, sizeof(_LE_Recording));
+    recording->hashInterval = 1;
+    return (LE_Recording*)recording;
+}
+
+void LE_RecordingSetHashInterval(LE_Recording* recording, int ticks) {
+    ((_LE_Recording*)recording)->hashInterval = ticks;
+}
+
+void LE_RecordingStart(LE_Recording* recording, LE_World* world) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    _LE_World* w = (_LE_World*)world;
+    LE_RecordingStop(recording);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    LE_WorldSync(world);
+    for (int i = 0; i < r->numLists; i++) {
+        LE_DestroySnapshot(r->initial[i]);
+    }
+    r->initial = _LE_Realloc(r->initial, sizeof(LE_Snapshot*) * (w->numLists ? w->numLists : 1), LE_MemoryTag_Recording);
+    r->numLists = w->numLists;
+    for (int i = 0; i < w->numLists; i++) {
+        r->initial[i] = LE_CreateSnapshot();
+        LE_SnapshotCapture(r->initial[i], w->lists[i], i == 0 ? w->layers : NULL);
+    }
+    r->size = 0;
+    r->numTicks = 0;
+    r->internal = 0;
+    r->world = w;
+    _LE_RecordSyncVelocities(r, false);
+    _LE_RecordAttach(r, w);
+}
+
+void LE_RecordingStop(LE_Recording* recording) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    if (!r->world) return;
+    LE_WorldSync((LE_World*)r->world);
+    _LE_RecordDetach(r->world);
+    r->world = NULL;
+}
+
+int LE_RecordingNumTicks(LE_Recording* recording) {
+    return ((_LE_Recording*)recording)->numTicks;
+}
+
+int LE_RecordingSize(LE_Recording* recording) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    int size = r->size;
+    for (int i = 0; i < r->numLists; i++) {
+        size += LE_SnapshotSize(r->initial[i]);
+    }
+    return size;
+}
+
+int LE_RecordingReplay(LE_Recording* recording, LE_World* world) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    _LE_World* w = (_LE_World*)world;
+    LE_RecordingStop(recording);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    LE_WorldSync(world);
+    if (w->numLists != r->numLists) return LE_REPLAY_INCOMPATIBLE;
+    for (int i = 0; i < w->numLists; i++) {
+        LE_SnapshotRestore(r->initial[i], w->lists[i], i == 0 ? w->layers : NULL);
+    }
+    int mismatch = -1;
+    int tick = 0;
+    for (int offset = 0; offset < r->size;) {
+        _LE_RecordEvent* event = (_LE_RecordEvent*)(r->data + offset);
+        LE_EntityList* list = event->list >= 0 && event->list < w->numLists ? w->lists[event->list] : NULL;
+        LE_Entity* entity = list && event->handle ? LE_EntityFromHandle(list, event->handle) : NULL;
+        _LE_EntityBuilder* builder;
+        offset += event->size;
+        switch (event->type) {
+            case _LE_RecordEvent_Tick:
+                if (w->layers) LE_UpdateLayerList(w->layers);
+                break;
+            case _LE_RecordEvent_Update:
+                for (int i = 0; i < w->numLists; i++) {
+                    LE_UpdateEntities(w->lists[i], event->update.delta);
+                }
+                w->ticks++;
+                if (event->update.hashed && mismatch < 0 && _LE_RecordHash(w) != event->update.hash) mismatch = tick;
+                tick++;
+                break;
+            case _LE_RecordEvent_Spawn:
+                builder = _LE_BuilderFromId(event->spawn.builder);
+                if (list && builder) LE_CreateEntity(list, (LE_EntityBuilder*)builder, event->spawn.x, event->spawn.y);
+                break;
+            case _LE_RecordEvent_Delete:
+                if (entity) LE_DeleteEntity(entity);
+                break;
+            case _LE_RecordEvent_Destroy:
+                if (entity) LE_DestroyEntity(entity);
+                break;
+            case _LE_RecordEvent_Position:
+                if (entity) LE_EntitySetPosition(entity, event->vector.x, event->vector.y);
+                break;
+            case _LE_RecordEvent_Velocity:
+                if (!entity) break;
+                entity->velX = event->vector.x;
+                entity->velY = event->vector.y;
+                break;
+            case _LE_RecordEvent_SetProperty:
+                if (entity) LE_EntitySetProperty(entity, event->property.value, (char*)(event + 1));
+                break;
+            case _LE_RecordEvent_DelProperty:
+                if (entity) LE_EntityDelProperty(entity, (char*)(event + 1));
+                break;
+            case _LE_RecordEvent_SetTile:
+                if (list && LE_EntityGetTilemap(list)) LE_TilemapSetTile(LE_EntityGetTilemap(list), event->tile.x, event->tile.y, event->tile.tile);
+                break;
+            case _LE_RecordEvent_Camera:
+                if (w->layers) LE_ScrollCamera(w->layers, event->vector.x, event->vector.y);
+                break;
+            case _LE_RecordEvent_Move:
+                if (entity && event->move.list >= 0 && event->move.list < w->numLists) LE_EntityChangeLists(entity, w->lists[event->move.list]);
+                break;
+        }
+    }
+    return mismatch;
+}
+
+const void* LE_RecordingGetData(LE_Recording* recording, int* size) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    int total = sizeof(_LE_RecordHeader);
+    for (int i = 0; i < r->numLists; i++) {
+        total += sizeof(_LE_RecordBlock) + LE_RECORD_ALIGN(LE_SnapshotSize(r->initial[i]));
+    }
+    int snapshotsSize = total - sizeof(_LE_RecordHeader);
+    total += r->size;
+    if (total > r->savedCapacity) {
+        r->savedCapacity = total;
+        r->saved = _LE_Realloc(r->saved, total, LE_MemoryTag_Recording);
+    }
+    memset(r->saved, 0, total);
+    _LE_RecordHeader* header = (_LE_RecordHeader*)r->saved;
+    header->magic = LE_RECORD_MAGIC;
+    header->numLists = r->numLists;
+    header->numTicks = r->numTicks;
+    header->hashInterval = r->hashInterval;
+    header->size = r->size;
+    header->snapshotsSize = snapshotsSize;
+    int offset = sizeof(_LE_RecordHeader);
+    for (int i = 0; i < r->numLists; i++) {
+        _LE_RecordBlock* block = (_LE_RecordBlock*)(r->saved + offset);
+        const void* data = LE_SnapshotGetData(r->initial[i], &block->size);
+        memcpy(block + 1, data, block->size);
+        offset += sizeof(_LE_RecordBlock) + LE_RECORD_ALIGN(block->size);
+    }
+    memcpy(r->saved + offset, r->data, r->size);
+    if (size) *size = total;
+    return r->saved;
+}
+
+static bool _LE_RecordInRange(float x, float y, float limit) {
+    return fabsf(x) <= limit && fabsf(y) <= limit;
+}
+
+static bool _LE_RecordEventValid(const _LE_RecordEvent* event, int remaining, int numLists) {
+    if (remaining < (int)sizeof(_LE_RecordEvent) || event->size < (int)sizeof(_LE_RecordEvent) || event->size > remaining || (event->size & 7)) return false;
+    if (event->list < -1 || event->list >= numLists) return false;
+    switch (event->type) {
+        case _LE_RecordEvent_Spawn:
+            return _LE_BuilderFromId(event->spawn.builder) && _LE_RecordInRange(event->spawn.x, event->spawn.y, LE_RECORD_MAX_COORD);
+        case _LE_RecordEvent_Position:
+        case _LE_RecordEvent_Velocity:
+            return _LE_RecordInRange(event->vector.x, event->vector.y, LE_RECORD_MAX_COORD);
+        case _LE_RecordEvent_Camera:
+            return _LE_RecordInRange(event->vector.x, event->vector.y, FLT_MAX);
+        case _LE_RecordEvent_Update:
+            return event->update.hashed <= 1 && _LE_RecordInRange(event->update.delta, 0, LE_RECORD_MAX_COORD);
+        case _LE_RecordEvent_SetProperty:
+        case _LE_RecordEvent_DelProperty: {
+            int nameLength = event->property.nameLength;
+            if (nameLength < 0 || nameLength >= event->size - (int)sizeof(_LE_RecordEvent)) return false;
+            return ((const char*)(event + 1))[nameLength] == 0 && (int)strlen((const char*)(event + 1)) == nameLength;
+        }
+        case _LE_RecordEvent_Tick:
+        case _LE_RecordEvent_Delete:
+        case _LE_RecordEvent_Destroy:
+        case _LE_RecordEvent_SetTile:
+        case _LE_RecordEvent_Move:
+            return true;
+    }
+    return false;
+}
+
+bool LE_RecordingLoad(LE_Recording* recording, const void* data, int size) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    const unsigned char* bytes = data;
+    const _LE_RecordHeader* header = data;
+    if (!data || size < (int)sizeof(_LE_RecordHeader) || header->magic != LE_RECORD_MAGIC) return false;
+    if (header->numLists < 0 || header->size < 0 || header->snapshotsSize < 0 || header->numTicks < 0) return false;
+    if ((long long)sizeof(_LE_RecordHeader) + header->snapshotsSize + header->size != size) return false;
+    if (header->numLists > header->snapshotsSize / (int)sizeof(_LE_RecordBlock)) return false;
+    int eventsOffset = sizeof(_LE_RecordHeader) + header->snapshotsSize;
+    for (int offset = eventsOffset; offset < size; offset += ((const _LE_RecordEvent*)(bytes + offset))->size) {
+        if (!_LE_RecordEventValid((const _LE_RecordEvent*)(bytes + offset), size - offset, header->numLists)) return false;
+    }
+    LE_Snapshot** initial = _LE_Malloc(sizeof(LE_Snapshot*) * (header->numLists ? header->numLists : 1), LE_MemoryTag_Recording);
+    int numLoaded = 0;
+    int offset = sizeof(_LE_RecordHeader);
+    for (; numLoaded < header->numLists; numLoaded++) {
+        const _LE_RecordBlock* block = (const _LE_RecordBlock*)(bytes + offset);
+        if (offset + (int)sizeof(_LE_RecordBlock) > eventsOffset) break;
+        if (block->size < 0 || block->size > eventsOffset - offset - (int)sizeof(_LE_RecordBlock)) break;
+        initial[numLoaded] = LE_CreateSnapshot();
+        if (!LE_SnapshotLoad(initial[numLoaded], NULL, block + 1, block->size) || LE_SnapshotIsDelta(initial[numLoaded])) {
+            LE_DestroySnapshot(initial[numLoaded]);
+            break;
+        }
+        offset += sizeof(_LE_RecordBlock) + LE_RECORD_ALIGN(block->size);
+    }
+    if (numLoaded < header->numLists || offset != eventsOffset) {
+        for (int i = 0; i < numLoaded; i++) {
+            LE_DestroySnapshot(initial[i]);
+        }
+        _LE_Free(initial);
+        return false;
+    }
+    LE_RecordingStop(recording);
+    for (int i = 0; i < r->numLists; i++) {
+        LE_DestroySnapshot(r->initial[i]);
+    }
+    _LE_Free(r->initial);
+    r->initial = initial;
+    r->numLists = header->numLists;
+    r->numTicks = header->numTicks;
+    r->hashInterval = header->hashInterval;
+    r->size = 0;
+    if (header->size > r->capacity) {
+        r->capacity = header->size;
+        r->data = _LE_Realloc(r->data, r->capacity, LE_MemoryTag_Recording);
+    }
+    memcpy(r->data, bytes + eventsOffset, header->size);
+    r->size = header->size;
+    return true;
+}
+
+void LE_DestroyRecording(LE_Recording* recording) {
+    _LE_Recording* r = (_LE_Recording*)recording;
+    LE_RecordingStop(recording);
+    for (int i = 0; i < r->numLists; i++) {
+        LE_DestroySnapshot(r->initial[i]);
+    }
+    _LE_Free(r->initial);
+    _LE_Free(r->data);
+    _LE_Free(r->saved);
+    _LE_Free(r);
+}
@@ -0,0 +1,33 @@
+#ifndef LUNAR_ENGINE_RECORD_H
+#define LUNAR_ENGINE_RECORD_H
+
+#include "lunarengine.h"
+
+typedef enum {
+    _LE_RecordEvent_Tick,
+    _LE_RecordEvent_Update,
+    _LE_RecordEvent_Spawn,
+    _LE_RecordEvent_Delete,
+    _LE_RecordEvent_Destroy,
+    _LE_RecordEvent_Position,
+    _LE_RecordEvent_Velocity,
+    _LE_RecordEvent_SetProperty,
+    _LE_RecordEvent_DelProperty,
+    _LE_RecordEvent_SetTile,
+    _LE_RecordEvent_Camera,
+    _LE_RecordEvent_Move,
+} _LE_RecordEventType;
+
+struct _LE_Recording;
+
+void _LE_RecordSpawn(struct _LE_Recording* recording, int list, LE_EntityBuilder* builder, float x, float y);
+void _LE_RecordEntity(struct _LE_Recording* recording, _LE_RecordEventType type, int list, unsigned int handle, float x, float y);
+void _LE_RecordProperty(struct _LE_Recording* recording, int list, unsigned int handle, LE_EntityProperty* value, const char* name);
+void _LE_RecordMove(struct _LE_Recording* recording, int list, unsigned int handle, int destlist);
+void _LE_RecordTile(struct _LE_Recording* recording, int list, int x, int y, int tile);
+void _LE_RecordCamera(struct _LE_Recording* recording, float x, float y);
+void _LE_RecordTickBegin(struct _LE_Recording* recording);
+void _LE_RecordUpdateBegin(struct _LE_Recording* recording, float delta);
+void _LE_RecordUpdateEnd(struct _LE_Recording* recording);
+
+#endif
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jobs.h"
+#include "lunarengine.h"
+#include "memory.h"
+#include "world.h"
+
+typedef struct {
+    _LE_World* world;
+    int ticks;
+    float cost;
+} _LE_ServerJob;
+
+typedef struct {
+    _LE_World** worlds;
+    _LE_ServerJob* jobs;
+    int numWorlds, capacity;
+    float tickCost;
+} _LE_Server;
+
+static int _LE_ServerJobCompare(const void* a, const void* b) {
+    float x = ((const _LE_ServerJob*)a)->cost;
+    float y = ((const _LE_ServerJob*)b)->cost;
+    return (x < y) - (x > y);
+}
+
+static void _LE_ServerRunJobs(void* userdata, int start, int end) {
+    _LE_ServerJob* jobs = userdata;
+    bool prev = _LE_JobsSetInline(true);
+    for (int i = start; i < end; i++) {
+        _LE_WorldRunTicks(jobs[i].world, jobs[i].ticks);
+    }
+    _LE_JobsSetInline(prev);
+}
+
+static int _LE_ServerRun(_LE_Server* server) {
+    int numJobs = 0;
+    int total = 0;
+    for (int i = 0; i < server->numWorlds; i++) {
+        _LE_ServerJob* job = &server->jobs[i];
+        if (job->ticks == 0) continue;
+        total += job->ticks;
+        job->cost = job->world->avgTickCost * job->ticks;
+        server->jobs[numJobs++] = *job;
+    }
+    if (numJobs > 1) qsort(server->jobs, numJobs, sizeof(_LE_ServerJob), _LE_ServerJobCompare);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    _LE_JobsParallelFor(numJobs, 1, _LE_ServerRunJobs, server->jobs);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    server->tickCost = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    return total;
+}
+
+LE_Server* LE_CreateServer() {
+    _LE_Server* server = _LE_Malloc(sizeof(_LE_Server), LE_MemoryTag_World);
+    memset(server, 0, sizeof(_LE_Server));
+    return (LE_Server*)server;
+}
+
+void LE_ServerAddWorld(LE_Server* server, LE_World* world) {
+    _LE_Server* s = (_LE_Server*)server;
+    LE_WorldSetPipelined(world, false);
+    if (s->numWorlds == s->capacity) {
+        s->capacity = s->capacity ? s->capacity * 2 : 16;
+        s->worlds = _LE_Realloc(s->worlds, sizeof(_LE_World*) * s->capacity, LE_MemoryTag_World);
+        s->jobs = _LE_Realloc(s->jobs, sizeof(_LE_ServerJob) * s->capacity, LE_MemoryTag_World);
+    }
+    s->worlds[s->numWorlds++] = (_LE_World*)world;
+}
+
+void LE_ServerRemoveWorld(LE_Server* server, LE_World* world) {
+    _LE_Server* s = (_LE_Server*)server;
+    for (int i = 0; i < s->numWorlds; i++) {
+        if (s->worlds[i] != (_LE_World*)world) continue;
+        memmove(s->worlds + i, s->worlds + i + 1, sizeof(_LE_World*) * (s->numWorlds - i - 1));
+        s->numWorlds--;
+        return;
+    }
+}
+
+int LE_ServerNumWorlds(LE_Server* server) {
+    return ((_LE_Server*)server)->numWorlds;
+}
+
+LE_World* LE_ServerGetWorld(LE_Server* server, int index) {
+    _LE_Server* s = (_LE_Server*)server;
+    if (index < 0 || index >= s->numWorlds) return NULL;
+    return (LE_World*)s->worlds[index];
+}
+
+int LE_ServerAdvance(LE_Server* server, float seconds) {
+    _LE_Server* s = (_LE_Server*)server;
+    for (int i = 0; i < s->numWorlds; i++) {
+        s->jobs[i].world = s->worlds[i];
+        s->jobs[i].ticks = _LE_WorldConsume(s->worlds[i], seconds);
+    }
+    return _LE_ServerRun(s);
+}
+
+void LE_ServerTick(LE_Server* server) {
+    _LE_Server* s = (_LE_Server*)server;
+    for (int i = 0; i < s->numWorlds; i++) {
+        s->jobs[i].world = s->worlds[i];
+        s->jobs[i].ticks = 1;
+    }
+    _LE_ServerRun(s);
+}
+
+float LE_ServerGetTickCost(LE_Server* server) {
+    return ((_LE_Server*)server)->tickCost;
+}
+
+void LE_DestroyServer(LE_Server* server) {
+    _LE_Server* s = (_LE_Server*)server;
+    for (int i = 0; i < s->numWorlds; i++) {
+        LE_DestroyWorld((LE_World*)s->worlds[i]);
+    }
+    _LE_Free(s->worlds);
+    _LE_Free(s->jobs);
+    _LE_Free(s);
+}
@@ -0,0 +1,904 @@
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "entity.h"
+#include "layer.h"
+#include "linked_list.h"
+#include "lunarengine.h"
+#include "memory.h"
+#include "tile.h"
+
+#define LE_SNAPSHOT_MAGIC 0x50534E4C
+#define LE_SNAPSHOT_MAX_COORD 1073741824.f
+
+typedef struct {
+    unsigned int magic;
+    unsigned char delta;
+    unsigned char hasCamera;
+    unsigned char hasTilemap;
+    int numLayers;
+    int numTiles;
+    int tilemapW, tilemapH;
+    int numEntities;
+    int numRemoved;
+    int layersOffset;
+    int tilesOffset;
+    int entitiesOffset;
+    int removedOffset;
+    int numContacts;
+    int contactsOffset;
+    unsigned int contactStamp;
+    unsigned int nextHandle;
+    unsigned long long nextSeq;
+    float camPosX, camPosY;
+    float prevCamPosX, prevCamPosY;
+} _LE_SnapshotHeader;
+
+typedef struct {
+    float scrollOffsetX, scrollSpeedX;
+    float scrollOffsetY, scrollSpeedY;
+    float scaleW, scaleH;
+    float prevScrollOffsetX, prevScrollSpeedX;
+    float prevScrollOffsetY, prevScrollSpeedY;
+    float prevScaleW, prevScaleH;
+} _LE_LayerRecord;
+
+typedef struct {
+    int size;
+    unsigned int handle;
+    unsigned int platform;
+    int numProperties;
+    unsigned long long seq;
+    unsigned int builder;
+    float posX, posY;
+    float velX, velY;
+    float width, height;
+    int drawPriority;
+    LE_EntityFlags flags;
+    unsigned int category, mask;
+    float prevPosX, prevPosY;
+    float lastDrawnX, lastDrawnY;
+    float spriteW, spriteH;
+    unsigned char deleted;
+    unsigned char dormant;
+} _LE_EntityRecord;
+
+typedef struct {
+    LE_EntityProperty value;
+    int nameLength;
+} _LE_PropertyRecord;
+
+typedef struct {
+    unsigned int entity;
+    unsigned int collider;
+    unsigned int colliderList;
+    int tile;
+    int tileX, tileY;
+    LE_Direction direction;
+    unsigned int stamp;
+    LE_ContactPhase phase;
+} _LE_ContactRecord;
+
+typedef struct _LE_Snapshot {
+    unsigned char* data;
+    int size, capacity;
+    struct _LE_Snapshot* base;
+    int* index;
+    int indexCapacity;
+    bool indexed;
+    unsigned long long* riders;
+    int numRiders, riderCapacity;
+    int minTile, maxTile;
+    unsigned long long generation;
+} _LE_Snapshot;
+
+static atomic_ullong snapshotGeneration;
+
+#define LE_SNAPSHOT_ALIGN(x) (((x) + 7) & ~7)
+#define LE_SNAPSHOT_AT(snapshot, type, offset) ((type*)((snapshot)->data + (offset)))
+
+static int _LE_SnapshotReserve(_LE_Snapshot* snapshot, int bytes) {
+    int offset = snapshot->size;
+    bytes = LE_SNAPSHOT_ALIGN(bytes);
+    if (offset + bytes > snapshot->capacity) {
+        while (offset + bytes > snapshot->capacity) snapshot->capacity = snapshot->capacity ? snapshot->capacity * 2 : 4096;
+        snapshot->data = _LE_Realloc(snapshot->data, snapshot->capacity, LE_MemoryTag_Snapshot);
+    }
+    memset(snapshot->data + offset, 0, bytes);
+    snapshot->size += bytes;
+    return offset;
+}
+
+static int _LE_CompareRiders(const void* left, const void* right) {
+    unsigned long long l = *(const unsigned long long*)left;
+    unsigned long long r = *(const unsigned long long*)right;
+    return (l > r) - (l < r);
+}
+
+static void _LE_SnapshotIndexSlot(_LE_Snapshot* snapshot, unsigned int handle, int value) {
+    unsigned int mask = snapshot->indexCapacity - 1;
+    unsigned int slot = (handle * 2654435761u) & mask;
+    while (snapshot->index[slot] != -1) slot = (slot + 1) & mask;
+    snapshot->index[slot] = value;
+}
+
+static void _LE_SnapshotIndex(_LE_Snapshot* snapshot) {
+    if (snapshot->indexed) return;
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    int capacity = 16;
+    while (capacity < (header->numEntities + header->numRemoved) * 2) capacity *= 2;
+    if (capacity > snapshot->indexCapacity) {
+        snapshot->index = _LE_Realloc(snapshot->index, sizeof(int) * capacity, LE_MemoryTag_Snapshot);
+        snapshot->indexCapacity = capacity;
+    }
+    memset(snapshot->index, 0xFF, sizeof(int) * snapshot->indexCapacity);
+    snapshot->numRiders = 0;
+    int offset = header->entitiesOffset;
+    for (int i = 0; i < header->numEntities; i++) {
+        _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+        _LE_SnapshotIndexSlot(snapshot, record->handle, offset);
+        if (record->platform) {
+            if (snapshot->numRiders == snapshot->riderCapacity) {
+                snapshot->riderCapacity = snapshot->riderCapacity ? snapshot->riderCapacity * 2 : 64;
+                snapshot->riders = _LE_Realloc(snapshot->riders, sizeof(unsigned long long) * snapshot->riderCapacity, LE_MemoryTag_Snapshot);
+            }
+            snapshot->riders[snapshot->numRiders++] = (unsigned long long)record->platform << 32 | record->handle;
+        }
+        offset += record->size;
+    }
+    if (snapshot->numRiders > 1) qsort(snapshot->riders, snapshot->numRiders, sizeof(unsigned long long), _LE_CompareRiders);
+    unsigned long long* removed = LE_SNAPSHOT_AT(snapshot, unsigned long long, header->removedOffset);
+    for (int i = 0; i < header->numRemoved; i++) _LE_SnapshotIndexSlot(snapshot, removed[i], -2 - i);
+    snapshot->indexed = true;
+}
+
+static _LE_EntityRecord* _LE_SnapshotLookup(_LE_Snapshot* snapshot, unsigned int handle, bool* removed) {
+    _LE_SnapshotIndex(snapshot);
+    unsigned long long* removedHandles = LE_SNAPSHOT_AT(snapshot, unsigned long long, LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0)->removedOffset);
+    unsigned int mask = snapshot->indexCapacity - 1;
+    unsigned int slot = (handle * 2654435761u) & mask;
+    while (snapshot->index[slot] != -1) {
+        int value = snapshot->index[slot];
+        if (value >= 0) {
+            _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, value);
+            if (record->handle == handle) return record;
+        }
+        else if (removedHandles[-2 - value] == handle) {
+            if (removed) *removed = true;
+            return NULL;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+static _LE_EntityRecord* _LE_SnapshotFind(_LE_Snapshot* snapshot, unsigned int handle) {
+    return _LE_SnapshotLookup(snapshot, handle, NULL);
+}
+
+static _LE_EntityRecord* _LE_SnapshotResolve(_LE_Snapshot* snapshot, unsigned int handle) {
+    bool removed = false;
+    _LE_EntityRecord* record = _LE_SnapshotLookup(snapshot, handle, &removed);
+    if (record || removed || !snapshot->base) return record;
+    return _LE_SnapshotFind(snapshot->base, handle);
+}
+
+static int _LE_SnapshotWriteEntity(_LE_Snapshot* snapshot, _LE_Entity* entity) {
+    int offset = _LE_SnapshotReserve(snapshot, sizeof(_LE_EntityRecord));
+    int numProperties = 0;
+    for (_LE_EntityPropList* prop = entity->properties->next; prop; prop = prop->next) {
+        int nameLength = strlen(prop->value->name);
+        int propOffset = _LE_SnapshotReserve(snapshot, sizeof(_LE_PropertyRecord) + nameLength + 1);
+        _LE_PropertyRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_PropertyRecord, propOffset);
+        record->value = prop->value->value;
+        record->nameLength = nameLength;
+        memcpy(record + 1, prop->value->name, nameLength + 1);
+        numProperties++;
+    }
+    _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+    _LE_Entity* platform = (_LE_Entity*)entity->platform;
+    record->size = snapshot->size - offset;
+    record->handle = entity->handle;
+    record->platform = platform && platform->parent && LE_EntityGetList((LE_Entity*)platform) == LE_EntityGetList((LE_Entity*)entity) ? platform->handle : 0;
+    record->numProperties = numProperties;
+    record->seq = entity->seq;
+    record->builder = entity->builder->id;
+    record->posX = entity->posX;
+    record->posY = entity->posY;
+    record->velX = entity->velX;
+    record->velY = entity->velY;
+    record->width = entity->width;
+    record->height = entity->height;
+    record->drawPriority = entity->drawPriority;
+    record->flags = entity->flags;
+    record->category = entity->category;
+    record->mask = entity->mask;
+    record->prevPosX = entity->prevPosX;
+    record->prevPosY = entity->prevPosY;
+    record->lastDrawnX = entity->lastDrawnX;
+    record->lastDrawnY = entity->lastDrawnY;
+    record->spriteW = entity->spriteW;
+    record->spriteH = entity->spriteH;
+    record->deleted = entity->deleted;
+    record->dormant = entity->dormant;
+    return offset;
+}
+
+static int _LE_SnapshotTileId(_LE_Tilemap* tilemap, _LE_Contact* contact) {
+    _LE_Tileset* tileset = tilemap ? tilemap->tileset : NULL;
+    if (!tileset) return 0;
+    if (contact->tileX >= 0 && contact->tileY >= 0 && contact->tileX < tilemap->width && contact->tileY < tilemap->height) {
+        int index = tilemap->data[contact->tileY * tilemap->width + contact->tileX];
+        if (index >= 0 && index < tileset->numTiles && (LE_TileData*)tileset->tiles[index] == contact->tile) return index + 1;
+    }
+    for (int i = 0; i < tileset->numTiles; i++) {
+        if ((LE_TileData*)tileset->tiles[i] == contact->tile) return i + 1;
+    }
+    return 0;
+}
+
+static void _LE_SnapshotTileRange(_LE_Snapshot* snapshot) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    int stride = header->delta ? 2 : 1;
+    int* tiles = LE_SNAPSHOT_AT(snapshot, int, header->tilesOffset);
+    snapshot->minTile = INT_MAX;
+    snapshot->maxTile = INT_MIN;
+    for (int i = 0; i < header->numTiles; i++) {
+        int tile = tiles[i * stride + stride - 1];
+        if (tile < snapshot->minTile) snapshot->minTile = tile;
+        if (tile > snapshot->maxTile) snapshot->maxTile = tile;
+    }
+}
+
+static bool _LE_SnapshotFits(_LE_Snapshot* snapshot, _LE_Tilemap* tilemap) {
+    if (!tilemap || !tilemap->tileset || snapshot->minTile > snapshot->maxTile) return true;
+    return snapshot->minTile >= 0 && snapshot->maxTile < tilemap->tileset->numTiles;
+}
+
+static void _LE_SnapshotWriteWorld(_LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers, _LE_Snapshot* base) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    snapshot->size = 0;
+    snapshot->base = base;
+    snapshot->indexed = false;
+    _LE_SnapshotReserve(snapshot, sizeof(_LE_SnapshotHeader));
+    _LE_SnapshotHeader header = {0};
+    header.magic = LE_SNAPSHOT_MAGIC;
+    header.delta = base != NULL;
+    header.nextHandle = data->nextHandle;
+    header.nextSeq = data->nextSeq;
+    if (layers) {
+        _LE_LayerList* ll = (_LE_LayerList*)layers;
+        header.hasCamera = true;
+        header.camPosX = ll->value->cameraData.camPosX;
+        header.camPosY = ll->value->cameraData.camPosY;
+        header.prevCamPosX = ll->value->cameraData.prevCamPosX;
+        header.prevCamPosY = ll->value->cameraData.prevCamPosY;
+        header.numLayers = LE_LL_Size(layers);
+        header.layersOffset = _LE_SnapshotReserve(snapshot, sizeof(_LE_LayerRecord) * header.numLayers);
+        _LE_LayerRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_LayerRecord, header.layersOffset);
+        while (ll->next) {
+            ll = ll->next;
+            memcpy(record++, ll->value, sizeof(_LE_LayerRecord));
+        }
+    }
+    if (tilemap) {
+        header.hasTilemap = true;
+        header.tilemapW = tilemap->width;
+        header.tilemapH = tilemap->height;
+        if (!base) {
+            header.numTiles = tilemap->width * tilemap->height;
+            header.tilesOffset = _LE_SnapshotReserve(snapshot, sizeof(int) * header.numTiles);
+            memcpy(snapshot->data + header.tilesOffset, tilemap->data, sizeof(int) * header.numTiles);
+        }
+        else {
+            _LE_SnapshotHeader* baseHeader = LE_SNAPSHOT_AT(base, _LE_SnapshotHeader, 0);
+            int* baseTiles = LE_SNAPSHOT_AT(base, int, baseHeader->tilesOffset);
+            header.tilesOffset = snapshot->size;
+            for (int row = 0; row < tilemap->height; row++) {
+                int* curr = tilemap->data + row * tilemap->width;
+                int* prev = baseTiles + row * tilemap->width;
+                if (memcmp(curr, prev, sizeof(int) * tilemap->width) == 0) continue;
+                for (int x = 0; x < tilemap->width; x++) {
+                    if (curr[x] == prev[x]) continue;
+                    int offset = _LE_SnapshotReserve(snapshot, sizeof(int) * 2);
+                    LE_SNAPSHOT_AT(snapshot, int, offset)[0] = row * tilemap->width + x;
+                    LE_SNAPSHOT_AT(snapshot, int, offset)[1] = curr[x];
+                    header.numTiles++;
+                }
+            }
+        }
+    }
+    header.contactStamp = data->contactStamp;
+    header.contactsOffset = _LE_SnapshotReserve(snapshot, sizeof(_LE_ContactRecord) * data->numContacts);
+    for (int i = 0; i < data->numContacts; i++) {
+        _LE_Contact* contact = &data->contacts[i];
+        _LE_ContactRecord record = {
+            .entity = contact->entity, .collider = contact->collider,
+            .colliderList = contact->colliderList ? LE_ENTITY_LIST_DATA(contact->colliderList)->id : 0,
+            .tile = contact->tile ? _LE_SnapshotTileId(tilemap, contact) : 0,
+            .tileX = contact->tileX, .tileY = contact->tileY,
+            .direction = contact->direction, .stamp = contact->stamp, .phase = contact->phase
+        };
+        if (contact->tile && !record.tile) continue;
+        LE_SNAPSHOT_AT(snapshot, _LE_ContactRecord, header.contactsOffset)[header.numContacts++] = record;
+    }
+    header.entitiesOffset = snapshot->size;
+    for (_LE_EntityList* curr = ((_LE_EntityList*)list)->next; curr; curr = curr->next) {
+        int offset = _LE_SnapshotWriteEntity(snapshot, curr->value);
+        if (base) {
+            _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+            _LE_EntityRecord* prev = _LE_SnapshotFind(base, record->handle);
+            if (prev && prev->size == record->size && memcmp(prev, record, record->size) == 0) {
+                snapshot->size = offset;
+                continue;
+            }
+        }
+        header.numEntities++;
+    }
+    if (base) {
+        _LE_SnapshotHeader* baseHeader = LE_SNAPSHOT_AT(base, _LE_SnapshotHeader, 0);
+        header.removedOffset = snapshot->size;
+        int offset = baseHeader->entitiesOffset;
+        for (int i = 0; i < baseHeader->numEntities; i++) {
+            _LE_EntityRecord* record = LE_SNAPSHOT_AT(base, _LE_EntityRecord, offset);
+            offset += record->size;
+            if (LE_EntityFromHandle(list, record->handle)) continue;
+            unsigned long long handle = record->handle;
+            int removed = _LE_SnapshotReserve(snapshot, sizeof(unsigned long long));
+            *LE_SNAPSHOT_AT(snapshot, unsigned long long, removed) = handle;
+            header.numRemoved++;
+        }
+    }
+    memcpy(snapshot->data, &header, sizeof(_LE_SnapshotHeader));
+    _LE_SnapshotTileRange(snapshot);
+    snapshot->generation = atomic_fetch_add(&snapshotGeneration, 1) + 1;
+}
+
+static _LE_PropertyRecord* _LE_SnapshotNextProperty(_LE_PropertyRecord* prop) {
+    return (_LE_PropertyRecord*)((unsigned char*)prop + LE_SNAPSHOT_ALIGN(sizeof(_LE_PropertyRecord) + prop->nameLength + 1));
+}
+
+static bool _LE_SnapshotPropertiesMatch(_LE_EntityPropList* list, _LE_EntityRecord* record, bool values) {
+    _LE_PropertyRecord* prop = (_LE_PropertyRecord*)(record + 1);
+    _LE_EntityPropList* curr = list->next;
+    for (int i = 0; i < record->numProperties; i++) {
+        if (!curr || strcmp(curr->value->name, (char*)(prop + 1)) != 0) return false;
+        if (values && memcmp(&curr->value->value, &prop->value, sizeof(LE_EntityProperty)) != 0) return false;
+        curr = curr->next;
+        prop = _LE_SnapshotNextProperty(prop);
+    }
+    return !curr;
+}
+
+static void _LE_SnapshotReadProperties(_LE_Entity* entity, _LE_EntityRecord* record) {
+    if (_LE_SnapshotPropertiesMatch(entity->properties, record, true)) return;
+    if (_LE_SnapshotPropertiesMatch(entity->builder->properties, record, true)) {
+        _LE_EntityShareProperties(entity);
+        return;
+    }
+    _LE_PropertyRecord* prop = (_LE_PropertyRecord*)(record + 1);
+    if (_LE_SnapshotPropertiesMatch(entity->properties, record, false)) {
+        _LE_EntityOwnProperties(entity);
+        for (_LE_EntityPropList* curr = entity->properties->next; curr; curr = curr->next) {
+            curr->value->value = prop->value;
+            prop = _LE_SnapshotNextProperty(prop);
+        }
+        return;
+    }
+    _LE_EntityReleaseProperties(entity);
+    entity->properties = LE_LL_Create();
+    _LE_EntityPropList* tail = entity->properties;
+    for (int i = 0; i < record->numProperties; i++) {
+        tail = _LE_AppendProperty(tail, prop->value, (char*)(prop + 1));
+        prop = _LE_SnapshotNextProperty(prop);
+    }
+}
+
+static _LE_Entity* _LE_SnapshotReadEntity(LE_EntityList* list, _LE_EntityRecord* record) {
+    _LE_EntityBuilder* builder = _LE_BuilderFromId(record->builder);
+    if (!builder) return NULL;
+    _LE_Entity* entity = (_LE_Entity*)LE_EntityFromHandle(list, record->handle);
+    bool created = !entity;
+    if (created) {
+        entity = _LE_Malloc(sizeof(_LE_Entity), LE_MemoryTag_Entity);
+        memset(entity, 0, sizeof(_LE_Entity));
+    }
+    entity->handle = record->handle;
+    entity->seq = record->seq;
+    entity->builder = builder;
+    entity->posX = record->posX;
+    entity->posY = record->posY;
+    entity->velX = record->velX;
+    entity->velY = record->velY;
+    entity->width = record->width;
+    entity->height = record->height;
+    entity->drawPriority = record->drawPriority;
+    entity->flags = record->flags;
+    entity->category = record->category;
+    entity->mask = record->mask;
+    entity->prevPosX = record->prevPosX;
+    entity->prevPosY = record->prevPosY;
+    entity->lastDrawnX = record->lastDrawnX;
+    entity->lastDrawnY = record->lastDrawnY;
+    entity->spriteW = record->spriteW;
+    entity->spriteH = record->spriteH;
+    entity->spriteCached = false;
+    entity->deleted = record->deleted != 0;
+    entity->dormant = record->dormant != 0;
+    if (created) {
+        _LE_EntityShareProperties(entity);
+        _LE_LinkEntity(entity, list);
+    }
+    else {
+        _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+        if (entity->drawPriority != entity->sortedPriority) data->drawOrderDirty = true;
+        data->idleStep = fmaxf(data->idleStep, _LE_EntityStep(entity));
+    }
+    _LE_SnapshotReadProperties(entity, record);
+    return entity;
+}
+
+static int _LE_CompareListOrder(const void* left, const void* right) {
+    unsigned long long l = (*(_LE_EntityList**)left)->value->seq;
+    unsigned long long r = (*(_LE_EntityList**)right)->value->seq;
+    return (l > r) - (l < r);
+}
+
+static void _LE_SnapshotRebuildList(LE_EntityList* list) {
+    _LE_EntityList* head = (_LE_EntityList*)list;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    int count = 0;
+    bool sorted = true;
+    for (_LE_EntityList* curr = head->next; curr; curr = curr->next) {
+        if (curr->prev != head && curr->prev->value->seq > curr->value->seq) sorted = false;
+        count++;
+    }
+    if (!sorted) {
+        _LE_EntityList** nodes = _LE_Malloc(sizeof(_LE_EntityList*) * count, LE_MemoryTag_Snapshot);
+        int i = 0;
+        for (_LE_EntityList* curr = head->next; curr; curr = curr->next) nodes[i++] = curr;
+        qsort(nodes, count, sizeof(_LE_EntityList*), _LE_CompareListOrder);
+        _LE_EntityList* prev = head;
+        for (i = 0; i < count; i++) {
+            prev->next = nodes[i];
+            nodes[i]->prev = prev;
+            prev = nodes[i];
+        }
+        prev->next = NULL;
+        data->tail = prev;
+        _LE_Free(nodes);
+    }
+    data->numActive = 0;
+    data->numPendingDelete = 0;
+    data->drawOrderDirty = true;
+    for (_LE_EntityList* curr = head->next; curr; curr = curr->next) {
+        _LE_Entity* entity = curr->value;
+        entity->activeStamp = 0;
+        entity->activeIndex = -1;
+        if (entity->deleted) {
+            entity->pendingIndex = data->numPendingDelete;
+            _LE_PushEntity(&data->pendingDelete, &data->numPendingDelete, &data->pendingDeleteCapacity, entity);
+        }
+        else if (!entity->dormant) {
+            entity->activeIndex = data->numActive;
+            _LE_PushEntity(&data->active, &data->numActive, &data->activeCapacity, entity);
+        }
+        _LE_EntityGridUpdate(data, entity, true);
+    }
+}
+
+static void _LE_SnapshotApplyLayers(_LE_Snapshot* snapshot, LE_LayerList* layers) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    if (layers && header->hasCamera) {
+        _LE_LayerList* ll = (_LE_LayerList*)layers;
+        _LE_LayerRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_LayerRecord, header->layersOffset);
+        ll->value->cameraData.camPosX = header->camPosX;
+        ll->value->cameraData.camPosY = header->camPosY;
+        ll->value->cameraData.prevCamPosX = header->prevCamPosX;
+        ll->value->cameraData.prevCamPosY = header->prevCamPosY;
+        for (int i = 0; i < header->numLayers && ll->next; i++) {
+            ll = ll->next;
+            memcpy(ll->value, record++, sizeof(_LE_LayerRecord));
+        }
+    }
+}
+
+static void _LE_SnapshotApplyContacts(_LE_Snapshot* snapshot, _LE_EntityListData* data) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    if (header->numContacts > data->contactCapacity) {
+        data->contactCapacity = header->numContacts;
+        data->contacts = _LE_Realloc(data->contacts, sizeof(_LE_Contact) * data->contactCapacity, LE_MemoryTag_Collision);
+    }
+    _LE_Tileset* tileset = tilemap ? tilemap->tileset : NULL;
+    _LE_ContactRecord* contacts = LE_SNAPSHOT_AT(snapshot, _LE_ContactRecord, header->contactsOffset);
+    data->numContacts = 0;
+    for (int i = 0; i < header->numContacts; i++) {
+        _LE_ContactRecord* record = &contacts[i];
+        _LE_Contact contact = {
+            .entity = record->entity, .collider = record->collider,
+            .colliderList = record->colliderList ? _LE_ListFromId(record->colliderList) : NULL,
+            .tileX = record->tileX, .tileY = record->tileY,
+            .direction = record->direction, .stamp = record->stamp, .phase = record->phase
+        };
+        if (record->colliderList && !contact.colliderList) continue;
+        if (record->tile) {
+            if (!tileset || record->tile < 0 || record->tile > tileset->numTiles) continue;
+            contact.tile = (LE_TileData*)tileset->tiles[record->tile - 1];
+        }
+        data->contacts[data->numContacts++] = contact;
+    }
+    data->contactStamp = header->contactStamp;
+    _LE_RebuildContactIndex(data);
+    data->nextHandle = header->nextHandle;
+    data->nextSeq = header->nextSeq;
+}
+
+static void _LE_SnapshotApply(_LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    _LE_SnapshotApplyLayers(snapshot, layers);
+    if (tilemap && header->hasTilemap) {
+        int* tiles = LE_SNAPSHOT_AT(snapshot, int, header->tilesOffset);
+        if (!header->delta) {
+            if (tilemap->width != header->tilemapW || tilemap->height != header->tilemapH) {
+                tilemap->width = header->tilemapW;
+                tilemap->height = header->tilemapH;
+                tilemap->data = _LE_Realloc(tilemap->data, sizeof(int) * header->numTiles, LE_MemoryTag_Tile);
+            }
+            memcpy(tilemap->data, tiles, sizeof(int) * header->numTiles);
+        }
+        else if (tilemap->width == header->tilemapW && tilemap->height == header->tilemapH) {
+            for (int i = 0; i < header->numTiles; i++) tilemap->data[tiles[i * 2]] = tiles[i * 2 + 1];
+        }
+    }
+    if (header->delta) {
+        unsigned long long* removed = LE_SNAPSHOT_AT(snapshot, unsigned long long, header->removedOffset);
+        for (int i = 0; i < header->numRemoved; i++) {
+            LE_Entity* entity = LE_EntityFromHandle(list, removed[i]);
+            if (entity) _LE_DestroyEntity((_LE_Entity*)entity);
+        }
+    }
+    else {
+        _LE_EntityList* curr = ((_LE_EntityList*)list)->next;
+        while (curr) {
+            _LE_EntityList* next = curr->next;
+            if (!_LE_SnapshotFind(snapshot, curr->value->handle)) _LE_DestroyEntity(curr->value);
+            curr = next;
+        }
+    }
+    int offset = header->entitiesOffset;
+    for (int i = 0; i < header->numEntities; i++) {
+        _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+        _LE_SnapshotReadEntity(list, record);
+        offset += record->size;
+    }
+    offset = header->entitiesOffset;
+    for (int i = 0; i < header->numEntities; i++) {
+        _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+        _LE_Entity* entity = (_LE_Entity*)LE_EntityFromHandle(list, record->handle);
+        if (entity) entity->platform = record->platform ? LE_EntityFromHandle(list, record->platform) : NULL;
+        offset += record->size;
+    }
+    _LE_SnapshotApplyContacts(snapshot, data);
+}
+
+typedef void (*_LE_SnapshotVisitor)(_LE_Snapshot* snapshot, LE_EntityList* list, unsigned int handle);
+
+static void _LE_SnapshotVisitChanged(_LE_Snapshot* snapshot, LE_EntityList* list, _LE_SnapshotVisitor visitor) {
+    _LE_SnapshotSync* sync = &LE_ENTITY_LIST_DATA(list)->sync;
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    for (int i = 0; i < sync->numHandles; i++) visitor(snapshot, list, sync->handles[i]);
+    if (!header->delta) return;
+    int offset = header->entitiesOffset;
+    for (int i = 0; i < header->numEntities; i++) {
+        _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+        visitor(snapshot, list, record->handle);
+        offset += record->size;
+    }
+    unsigned long long* removed = LE_SNAPSHOT_AT(snapshot, unsigned long long, header->removedOffset);
+    for (int i = 0; i < header->numRemoved; i++) visitor(snapshot, list, removed[i]);
+}
+
+static void _LE_SnapshotRestoreHandle(_LE_Snapshot* snapshot, LE_EntityList* list, unsigned int handle) {
+    _LE_EntityRecord* record = _LE_SnapshotResolve(snapshot, handle);
+    LE_Entity* entity = LE_EntityFromHandle(list, handle);
+    if (record) _LE_SnapshotReadEntity(list, record);
+    else if (entity) _LE_DestroyEntity((_LE_Entity*)entity);
+}
+
+static void _LE_SnapshotRestoreRiders(_LE_Snapshot* snapshot, LE_EntityList* list, unsigned int handle) {
+    _LE_Snapshot* full = snapshot->base ? snapshot->base : snapshot;
+    _LE_SnapshotIndex(full);
+    unsigned long long key = (unsigned long long)handle << 32;
+    int lo = 0, hi = full->numRiders;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (full->riders[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    LE_Entity* platform = LE_EntityFromHandle(list, handle);
+    for (int i = lo; i < full->numRiders && full->riders[i] >> 32 == handle; i++) {
+        _LE_Entity* rider = (_LE_Entity*)LE_EntityFromHandle(list, (unsigned int)full->riders[i]);
+        if (rider) rider->platform = platform;
+    }
+}
+
+static int _LE_CompareEntitySeq(const void* left, const void* right) {
+    unsigned long long l = (*(_LE_Entity**)left)->seq;
+    unsigned long long r = (*(_LE_Entity**)right)->seq;
+    return (l > r) - (l < r);
+}
+
+static void _LE_SnapshotPlaceNode(_LE_EntityListData* data, _LE_Entity* entity) {
+    _LE_EntityList* node = (_LE_EntityList*)entity->parent;
+    _LE_EntityList* head = node->frst;
+    if ((node->prev == head || node->prev->value->seq < entity->seq) && (!node->next || node->next->value->seq > entity->seq)) return;
+    if (data->tail == node) data->tail = node->prev;
+    node->prev->next = node->next;
+    if (node->next) node->next->prev = node->prev;
+    _LE_EntityList* pos = data->tail;
+    while (pos != head && pos->value->seq > entity->seq) pos = pos->prev;
+    node->prev = pos;
+    node->next = pos->next;
+    if (pos->next) pos->next->prev = node;
+    pos->next = node;
+    if (data->tail == pos) data->tail = node;
+}
+
+static void _LE_SnapshotRelinkHandle(_LE_Snapshot* snapshot, LE_EntityList* list, unsigned int handle) {
+    _LE_EntityRecord* record = _LE_SnapshotResolve(snapshot, handle);
+    _LE_Entity* entity = (_LE_Entity*)LE_EntityFromHandle(list, handle);
+    if (!record || !entity) return;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    entity->platform = record->platform ? LE_EntityFromHandle(list, record->platform) : NULL;
+    entity->activeStamp = 0;
+    bool pending = entity->pendingIndex >= 0 && entity->pendingIndex < data->numPendingDelete && data->pendingDelete[entity->pendingIndex] == entity;
+    if (entity->deleted && !pending) {
+        entity->pendingIndex = data->numPendingDelete;
+        _LE_PushEntity(&data->pendingDelete, &data->numPendingDelete, &data->pendingDeleteCapacity, entity);
+    }
+    else if (!entity->deleted && pending) data->pendingDelete[entity->pendingIndex] = NULL;
+    bool active = entity->activeIndex >= 0 && entity->activeIndex < data->numActive && data->active[entity->activeIndex] == entity;
+    if (!entity->deleted && !entity->dormant && !active) {
+        entity->activeIndex = data->numActive;
+        _LE_PushEntity(&data->active, &data->numActive, &data->activeCapacity, entity);
+    }
+    else if ((entity->deleted || entity->dormant) && active) {
+        data->active[entity->activeIndex] = NULL;
+        entity->activeIndex = -1;
+    }
+    _LE_EntityGridUpdate(data, entity, true);
+    _LE_SnapshotPlaceNode(data, entity);
+}
+
+static void _LE_SnapshotApplyChanges(_LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    _LE_Snapshot* full = snapshot->base ? snapshot->base : snapshot;
+    _LE_SnapshotHeader* fullHeader = LE_SNAPSHOT_AT(full, _LE_SnapshotHeader, 0);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_SnapshotSync* sync = &data->sync;
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    _LE_SnapshotApplyLayers(snapshot, layers);
+    if (tilemap && fullHeader->hasTilemap) {
+        int* baseTiles = LE_SNAPSHOT_AT(full, int, fullHeader->tilesOffset);
+        if (tilemap->version != sync->tileVersion) memcpy(tilemap->data, baseTiles, sizeof(int) * fullHeader->numTiles);
+        else for (int i = 0; i < sync->numTiles; i++) tilemap->data[sync->tiles[i]] = baseTiles[sync->tiles[i]];
+        int* tiles = LE_SNAPSHOT_AT(snapshot, int, header->tilesOffset);
+        for (int i = 0; header->delta && i < header->numTiles; i++) tilemap->data[tiles[i * 2]] = tiles[i * 2 + 1];
+    }
+    sync->generation = 0;
+    int numEntities = data->numHandles;
+    _LE_SnapshotVisitChanged(snapshot, list, _LE_SnapshotRestoreHandle);
+    _LE_SnapshotVisitChanged(snapshot, list, _LE_SnapshotRestoreRiders);
+    _LE_SnapshotVisitChanged(snapshot, list, _LE_SnapshotRelinkHandle);
+    int numActive = 0;
+    bool sorted = true;
+    for (int i = 0; i < data->numActive; i++) {
+        _LE_Entity* entity = data->active[i];
+        if (!entity) continue;
+        if (numActive > 0 && data->active[numActive - 1]->seq > entity->seq) sorted = false;
+        data->active[numActive++] = entity;
+    }
+    data->numActive = numActive;
+    if (!sorted) qsort(data->active, data->numActive, sizeof(_LE_Entity*), _LE_CompareEntitySeq);
+    for (int i = 0; i < data->numActive; i++) data->active[i]->activeIndex = i;
+    if (data->numHandles != numEntities) data->drawOrderDirty = true;
+    _LE_SnapshotApplyContacts(snapshot, data);
+}
+
+static void _LE_SnapshotSyncTo(_LE_Snapshot* snapshot, LE_EntityList* list) {
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(snapshot, _LE_SnapshotHeader, 0);
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    _LE_SnapshotSync* sync = &data->sync;
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    sync->generation = (snapshot->base ? snapshot->base : snapshot)->generation;
+    sync->stamp++;
+    sync->numHandles = 0;
+    sync->numTiles = 0;
+    sync->tilemap = data->tilemap;
+    sync->tileVersion = tilemap ? tilemap->version : 0;
+    if (!header->delta) return;
+    int offset = header->entitiesOffset;
+    for (int i = 0; i < header->numEntities; i++) {
+        _LE_EntityRecord* record = LE_SNAPSHOT_AT(snapshot, _LE_EntityRecord, offset);
+        _LE_SyncAddHandle(sync, record->handle);
+        offset += record->size;
+    }
+    unsigned long long* removed = LE_SNAPSHOT_AT(snapshot, unsigned long long, header->removedOffset);
+    for (int i = 0; i < header->numRemoved; i++) _LE_SyncAddHandle(sync, removed[i]);
+    if (!tilemap || !header->hasTilemap) return;
+    if (header->numTiles > sync->tileCapacity) {
+        sync->tileCapacity = header->numTiles;
+        sync->tiles = _LE_Realloc(sync->tiles, sizeof(int) * sync->tileCapacity, LE_MemoryTag_Snapshot);
+    }
+    int* tiles = LE_SNAPSHOT_AT(snapshot, int, header->tilesOffset);
+    for (int i = 0; i < header->numTiles; i++) sync->tiles[sync->numTiles++] = tiles[i * 2];
+}
+
+static bool _LE_SnapshotSynced(_LE_Snapshot* snapshot, _LE_EntityListData* data) {
+    _LE_Snapshot* full = snapshot->base ? snapshot->base : snapshot;
+    _LE_SnapshotHeader* header = LE_SNAPSHOT_AT(full, _LE_SnapshotHeader, 0);
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)data->tilemap;
+    if (!data->sync.generation || data->sync.generation != full->generation || data->sync.tilemap != data->tilemap) return false;
+    return !tilemap || !header->hasTilemap || (tilemap->width == header->tilemapW && tilemap->height == header->tilemapH);
+}
+
+LE_Snapshot* LE_CreateSnapshot() {
+    _LE_Snapshot* snapshot = _LE_Malloc(sizeof(_LE_Snapshot), LE_MemoryTag_Snapshot);
+    memset(snapshot, 0, sizeof(_LE_Snapshot));
+    return (LE_Snapshot*)snapshot;
+}
+
+void LE_SnapshotCapture(LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers) {
+    _LE_SnapshotWriteWorld((_LE_Snapshot*)snapshot, list, layers, NULL);
+    _LE_SnapshotSyncTo((_LE_Snapshot*)snapshot, list);
+}
+
+void LE_SnapshotCaptureDelta(LE_Snapshot* snapshot, LE_Snapshot* base, LE_EntityList* list, LE_LayerList* layers) {
+    _LE_Snapshot* b = (_LE_Snapshot*)base;
+    _LE_SnapshotHeader* header = b && b->size ? LE_SNAPSHOT_AT(b, _LE_SnapshotHeader, 0) : NULL;
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)LE_ENTITY_LIST_DATA(list)->tilemap;
+    bool compatible = header && !header->delta && header->hasTilemap == (tilemap != NULL);
+    if (compatible && tilemap) compatible = header->tilemapW == tilemap->width && header->tilemapH == tilemap->height;
+    _LE_SnapshotWriteWorld((_LE_Snapshot*)snapshot, list, layers, compatible ? b : NULL);
+    _LE_SnapshotSyncTo((_LE_Snapshot*)snapshot, list);
+}
+
+bool LE_SnapshotRestore(LE_Snapshot* snapshot, LE_EntityList* list, LE_LayerList* layers) {
+    _LE_Snapshot* s = (_LE_Snapshot*)snapshot;
+    _LE_Tilemap* tilemap = (_LE_Tilemap*)LE_ENTITY_LIST_DATA(list)->tilemap;
+    if (s->size == 0 || !_LE_SnapshotFits(s, tilemap) || (s->base && !_LE_SnapshotFits(s->base, tilemap))) return false;
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    if (_LE_SnapshotSynced(s, data)) _LE_SnapshotApplyChanges(s, list, layers);
+    else {
+        if (s->base) _LE_SnapshotApply(s->base, list, layers);
+        _LE_SnapshotApply(s, list, layers);
+        _LE_SnapshotRebuildList(list);
+    }
+    data->version++;
+    if (data->tilemap) ((_LE_Tilemap*)data->tilemap)->version++;
+    _LE_SnapshotSyncTo(s, list);
+    return true;
+}
+
+const void* LE_SnapshotGetData(LE_Snapshot* snapshot, int* size) {
+    _LE_Snapshot* s = (_LE_Snapshot*)snapshot;
+    if (size) *size = s->size;
+    return s->data;
+}
+
+static bool _LE_SnapshotInBounds(int size, int offset, long long count, int stride) {
+    if (count == 0) return true;
+    if (count < 0 || offset < (int)sizeof(_LE_SnapshotHeader) || offset > size || (offset & 7)) return false;
+    return count * stride <= size - offset;
+}
+
+static bool _LE_SnapshotInRange(const float* values, int count, float limit) {
+    for (int i = 0; i < count; i++) {
+        if (!(fabsf(values[i]) <= limit)) return false;
+    }
+    return true;
+}
+
+static bool _LE_SnapshotCheckEntities(const unsigned char* data, int size, const _LE_SnapshotHeader* header) {
+    int offset = header->entitiesOffset;
+    if (header->numEntities < 0) return false;
+    for (int i = 0; i < header->numEntities; i++) {
+        if (!_LE_SnapshotInBounds(size, offset, 1, sizeof(_LE_EntityRecord))) return false;
+        const _LE_EntityRecord* record = (const _LE_EntityRecord*)(data + offset);
+        if (record->size < (int)sizeof(_LE_EntityRecord) || (record->size & 7) || record->size > size - offset) return false;
+        if (record->numProperties < 0 || !_LE_BuilderFromId(record->builder)) return false;
+        if (record->handle > header->nextHandle || record->seq >= header->nextSeq) return false;
+        float values[] = {
+            record->posX, record->posY, record->velX, record->velY, record->width, record->height,
+            record->prevPosX, record->prevPosY, record->lastDrawnX, record->lastDrawnY, record->spriteW, record->spriteH
+        };
+        if (!_LE_SnapshotInRange(values, sizeof(values) / sizeof(float), LE_SNAPSHOT_MAX_COORD) || record->width < 0 || record->height < 0) return false;
+        int end = offset + record->size;
+        int prop = offset + sizeof(_LE_EntityRecord);
+        for (int j = 0; j < record->numProperties; j++) {
+            if (end - prop < (int)sizeof(_LE_PropertyRecord)) return false;
+            const _LE_PropertyRecord* p = (const _LE_PropertyRecord*)(data + prop);
+            if (p->nameLength < 0 || p->nameLength >= end - prop - (int)sizeof(_LE_PropertyRecord)) return false;
+            if (((const char*)(p + 1))[p->nameLength] != 0) return false;
+            prop += LE_SNAPSHOT_ALIGN(sizeof(_LE_PropertyRecord) + p->nameLength + 1);
+        }
+        if (prop != end) return false;
+        offset = end;
+    }
+    return true;
+}
+
+static bool _LE_SnapshotCheck(const unsigned char* data, int size, _LE_Snapshot* base) {
+    const _LE_SnapshotHeader* header = (const _LE_SnapshotHeader*)data;
+    if (size < (int)sizeof(_LE_SnapshotHeader) || header->magic != LE_SNAPSHOT_MAGIC) return false;
+    if (header->delta > 1 || header->hasCamera > 1 || header->hasTilemap > 1) return false;
+    if (!_LE_SnapshotInBounds(size, header->layersOffset, header->numLayers, sizeof(_LE_LayerRecord))) return false;
+    if (!_LE_SnapshotInRange(&header->camPosX, 4, FLT_MAX)) return false;
+    if (!_LE_SnapshotInRange((const float*)(data + header->layersOffset), header->numLayers * sizeof(_LE_LayerRecord) / sizeof(float), FLT_MAX)) return false;
+    if (!_LE_SnapshotInBounds(size, header->contactsOffset, header->numContacts, sizeof(_LE_ContactRecord))) return false;
+    const _LE_ContactRecord* contacts = (const _LE_ContactRecord*)(data + header->contactsOffset);
+    for (int i = 0; i < header->numContacts; i++) {
+        if (contacts[i].tile < 0) return false;
+    }
+    long long numTiles = 0;
+    if (header->hasTilemap) {
+        if (header->tilemapW < 0 || header->tilemapH < 0) return false;
+        numTiles = (long long)header->tilemapW * header->tilemapH;
+    }
+    else if (header->numTiles) return false;
+    if (header->delta) {
+        const _LE_SnapshotHeader* baseHeader = base && base->size ? LE_SNAPSHOT_AT(base, _LE_SnapshotHeader, 0) : NULL;
+        if (!baseHeader || baseHeader->delta || baseHeader->hasTilemap != header->hasTilemap) return false;
+        if (header->hasTilemap && (baseHeader->tilemapW != header->tilemapW || baseHeader->tilemapH != header->tilemapH)) return false;
+        if (!_LE_SnapshotInBounds(size, header->tilesOffset, header->numTiles, sizeof(int) * 2)) return false;
+        const int* tiles = (const int*)(data + header->tilesOffset);
+        for (int i = 0; i < header->numTiles; i++) {
+            if (tiles[i * 2] < 0 || tiles[i * 2] >= numTiles) return false;
+        }
+        if (!_LE_SnapshotInBounds(size, header->removedOffset, header->numRemoved, sizeof(unsigned long long))) return false;
+    }
+    else {
+        if (header->numTiles != numTiles || header->numRemoved) return false;
+        if (!_LE_SnapshotInBounds(size, header->tilesOffset, header->numTiles, sizeof(int))) return false;
+    }
+    return _LE_SnapshotCheckEntities(data, size, header);
+}
+
+bool LE_SnapshotLoad(LE_Snapshot* snapshot, LE_Snapshot* base, const void* data, int size) {
+    _LE_Snapshot* s = (_LE_Snapshot*)snapshot;
+    const _LE_SnapshotHeader* header = data;
+    if (!data || !_LE_SnapshotCheck(data, size, (_LE_Snapshot*)base)) return false;
+    s->size = 0;
+    _LE_SnapshotReserve(s, size);
+    memcpy(s->data, data, size);
+    s->size = size;
+    s->base = header->delta ? (_LE_Snapshot*)base : NULL;
+    s->indexed = false;
+    _LE_SnapshotTileRange(s);
+    s->generation = atomic_fetch_add(&snapshotGeneration, 1) + 1;
+    return true;
+}
+
+int LE_SnapshotSize(LE_Snapshot* snapshot) {
+    return ((_LE_Snapshot*)snapshot)->size;
+}
+
+bool LE_SnapshotIsDelta(LE_Snapshot* snapshot) {
+    _LE_Snapshot* s = (_LE_Snapshot*)snapshot;
+    return s->size && LE_SNAPSHOT_AT(s, _LE_SnapshotHeader, 0)->delta;
+}
+
+void LE_DestroySnapshot(LE_Snapshot* snapshot) {
+    _LE_Snapshot* s = (_LE_Snapshot*)snapshot;
+    _LE_Free(s->data);
+    _LE_Free(s->index);
+    _LE_Free(s->riders);
+    _LE_Free(s);
+}
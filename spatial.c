@@ -0,0 +1,434 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "collision.h"
+#include "entity.h"
+#include "memory.h"
+#include "spatial.h"
+
+#define LE_GRID_MAX_SPARE 64
+
+static unsigned int _LE_GridHash(int x, int y) {
+    return ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u);
+}
+
+static _LE_GridCell* _LE_GridFind(_LE_Grid* grid, int x, int y) {
+    if (grid->capacity == 0) return NULL;
+    unsigned int mask = grid->capacity - 1;
+    unsigned int i = _LE_GridHash(x, y) & mask;
+    while (grid->cells[i]) {
+        if (grid->cells[i]->x == x && grid->cells[i]->y == y) return grid->cells[i];
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+static void _LE_GridPlace(_LE_GridCell** cells, int capacity, _LE_GridCell* cell) {
+    unsigned int mask = capacity - 1;
+    unsigned int i = _LE_GridHash(cell->x, cell->y) & mask;
+    while (cells[i]) i = (i + 1) & mask;
+    cells[i] = cell;
+}
+
+static _LE_GridCell* _LE_GridGetOrCreate(_LE_Grid* grid, int x, int y) {
+    _LE_GridCell* cell = _LE_GridFind(grid, x, y);
+    if (cell) return cell;
+    if ((grid->used + 1) * 2 > grid->capacity) {
+        int capacity = grid->capacity ? grid->capacity * 2 : 64;
+        _LE_GridCell** cells = _LE_Calloc(capacity, sizeof(_LE_GridCell*), LE_MemoryTag_Spatial);
+        for (int i = 0; i < grid->capacity; i++) {
+            if (grid->cells[i]) _LE_GridPlace(cells, capacity, grid->cells[i]);
+        }
+        _LE_Free(grid->cells);
+        grid->cells = cells;
+        grid->capacity = capacity;
+    }
+    if (grid->used == 0 || x < grid->minX) grid->minX = x;
+    if (grid->used == 0 || y < grid->minY) grid->minY = y;
+    if (grid->used == 0 || x > grid->maxX) grid->maxX = x;
+    if (grid->used == 0 || y > grid->maxY) grid->maxY = y;
+    if (grid->spare) {
+        cell = grid->spare;
+        grid->spare = cell->nextEmpty;
+        grid->numSpare--;
+    }
+    else cell = _LE_Malloc(sizeof(_LE_GridCell), LE_MemoryTag_Spatial);
+    cell->x = x;
+    cell->y = y;
+    cell->count = 0;
+    cell->head = NULL;
+    cell->queued = false;
+    _LE_GridPlace(grid->cells, grid->capacity, cell);
+    grid->used++;
+    return cell;
+}
+
+static _LE_GridCell* _LE_GridCellFor(_LE_Grid* grid, _LE_Entity* entity) {
+    if (entity->width > grid->cellSize || entity->height > grid->cellSize) return &grid->large;
+    int x = floorf(entity->posX / grid->cellSize);
+    int y = floorf((entity->posY - entity->height / 2) / grid->cellSize);
+    if (entity->cell && entity->cell != &grid->large && entity->cell->x == x && entity->cell->y == y) return entity->cell;
+    return _LE_GridGetOrCreate(grid, x, y);
+}
+
+void _LE_GridInit(_LE_Grid* grid, float cellSize) {
+    memset(grid, 0, sizeof(_LE_Grid));
+    grid->cellSize = cellSize;
+}
+
+void _LE_GridFree(_LE_Grid* grid) {
+    for (int i = 0; i < grid->capacity; i++) {
+        _LE_Free(grid->cells[i]);
+    }
+    while (grid->spare) {
+        _LE_GridCell* cell = grid->spare;
+        grid->spare = cell->nextEmpty;
+        _LE_Free(cell);
+    }
+    _LE_Free(grid->cells);
+    grid->cells = NULL;
+    grid->capacity = grid->used = grid->numSpare = 0;
+    grid->empty = NULL;
+}
+
+static void _LE_GridLink(_LE_GridCell* cell, _LE_Entity* entity) {
+    entity->cell = cell;
+    entity->cellPrev = NULL;
+    entity->cellNext = cell->head;
+    if (cell->head) cell->head->cellPrev = entity;
+    cell->head = entity;
+    cell->count++;
+}
+
+void _LE_GridInsert(_LE_Grid* grid, _LE_Entity* entity) {
+    entity->cell = NULL;
+    _LE_GridLink(_LE_GridCellFor(grid, entity), entity);
+}
+
+void _LE_GridRemove(_LE_Grid* grid, _LE_Entity* entity) {
+    _LE_GridCell* cell = entity->cell;
+    if (!cell) return;
+    if (entity->cellPrev) entity->cellPrev->cellNext = entity->cellNext;
+    else cell->head = entity->cellNext;
+    if (entity->cellNext) entity->cellNext->cellPrev = entity->cellPrev;
+    cell->count--;
+    entity->cell = NULL;
+    if (cell->count > 0 || cell == &grid->large || cell->queued) return;
+    cell->queued = true;
+    cell->nextEmpty = grid->empty;
+    grid->empty = cell;
+}
+
+static void _LE_GridErase(_LE_Grid* grid, _LE_GridCell* cell) {
+    unsigned int mask = grid->capacity - 1;
+    unsigned int i = _LE_GridHash(cell->x, cell->y) & mask;
+    while (grid->cells[i] != cell) i = (i + 1) & mask;
+    for (unsigned int j = (i + 1) & mask; grid->cells[j]; j = (j + 1) & mask) {
+        unsigned int home = _LE_GridHash(grid->cells[j]->x, grid->cells[j]->y) & mask;
+        if (i <= j ? i < home && home <= j : i < home || home <= j) continue;
+        grid->cells[i] = grid->cells[j];
+        i = j;
+    }
+    grid->cells[i] = NULL;
+    grid->used--;
+}
+
+void _LE_GridReclaim(_LE_Grid* grid) {
+    bool edge = false;
+    while (grid->empty) {
+        _LE_GridCell* cell = grid->empty;
+        grid->empty = cell->nextEmpty;
+        cell->queued = false;
+        if (cell->count > 0) continue;
+        if (cell->x == grid->minX || cell->x == grid->maxX || cell->y == grid->minY || cell->y == grid->maxY) edge = true;
+        _LE_GridErase(grid, cell);
+        if (grid->numSpare == LE_GRID_MAX_SPARE) {
+            _LE_Free(cell);
+            continue;
+        }
+        cell->nextEmpty = grid->spare;
+        grid->spare = cell;
+        grid->numSpare++;
+    }
+    if (!edge || grid->used == 0) return;
+    bool first = true;
+    for (int i = 0; i < grid->capacity; i++) {
+        _LE_GridCell* cell = grid->cells[i];
+        if (!cell) continue;
+        if (first || cell->x < grid->minX) grid->minX = cell->x;
+        if (first || cell->y < grid->minY) grid->minY = cell->y;
+        if (first || cell->x > grid->maxX) grid->maxX = cell->x;
+        if (first || cell->y > grid->maxY) grid->maxY = cell->y;
+        first = false;
+    }
+}
+
+void _LE_GridUpdate(_LE_Grid* grid, _LE_Entity* entity) {
+    _LE_GridCell* cell = _LE_GridCellFor(grid, entity);
+    if (cell == entity->cell) return;
+    _LE_GridRemove(grid, entity);
+    _LE_GridLink(cell, entity);
+}
+
+static bool _LE_GridVisitCell(_LE_GridCell* cell, _LE_GridVisitor visitor, void* userdata) {
+    _LE_Entity* curr = cell->head;
+    while (curr) {
+        _LE_Entity* next = curr->cellNext;
+        if (!visitor(curr, userdata)) return false;
+        curr = next;
+    }
+    return true;
+}
+
+bool _LE_GridQuery(_LE_Grid* grid, float x1, float y1, float x2, float y2, _LE_GridVisitor visitor, void* userdata) {
+    if (!_LE_GridVisitCell(&grid->large, visitor, userdata)) return false;
+    if (grid->used == 0) return true;
+    float half = grid->cellSize / 2;
+    float fx = floorf((x1 - half) / grid->cellSize);
+    float fy = floorf((y1 - half) / grid->cellSize);
+    float tx = floorf((x2 + half) / grid->cellSize);
+    float ty = floorf((y2 + half) / grid->cellSize);
+    if ((tx - fx + 1) * (ty - fy + 1) > grid->capacity) {
+        for (int i = 0; i < grid->capacity; i++) {
+            _LE_GridCell* cell = grid->cells[i];
+            if (!cell || cell->count == 0) continue;
+            if (cell->x < fx || cell->x > tx || cell->y < fy || cell->y > ty) continue;
+            if (!_LE_GridVisitCell(cell, visitor, userdata)) return false;
+        }
+        return true;
+    }
+    for (int y = fy; y <= ty; y++) {
+        for (int x = fx; x <= tx; x++) {
+            _LE_GridCell* cell = _LE_GridFind(grid, x, y);
+            if (!cell || cell->count == 0) continue;
+            if (!_LE_GridVisitCell(cell, visitor, userdata)) return false;
+        }
+    }
+    return true;
+}
+
+static bool _LE_ClipRay(float origin, float dir, float lo, float hi, float* enter, float* exit) {
+    if (dir == 0) return origin >= lo && origin <= hi;
+    float t1 = (lo - origin) / dir;
+    float t2 = (hi - origin) / dir;
+    if (t1 > t2) {
+        float tmp = t1;
+        t1 = t2;
+        t2 = tmp;
+    }
+    if (t1 > *enter) *enter = t1;
+    if (t2 < *exit) *exit = t2;
+    return *enter <= *exit;
+}
+
+bool _LE_GridRaycast(_LE_Grid* grid, float x, float y, float dirX, float dirY, float* maxDistance, _LE_GridVisitor visitor, void* userdata) {
+    if (!_LE_GridVisitCell(&grid->large, visitor, userdata)) return false;
+    if (grid->used == 0) return true;
+    float size = grid->cellSize;
+    float enter = 0;
+    float exit = *maxDistance;
+    if (!_LE_ClipRay(x, dirX, (grid->minX - 1) * size, (grid->maxX + 2) * size, &enter, &exit)) return true;
+    if (!_LE_ClipRay(y, dirY, (grid->minY - 1) * size, (grid->maxY + 2) * size, &enter, &exit)) return true;
+    x += dirX * enter;
+    y += dirY * enter;
+    int cx = floorf(x / size);
+    int cy = floorf(y / size);
+    int stepX = dirX > 0 ? 1 : dirX < 0 ? -1 : 0;
+    int stepY = dirY > 0 ? 1 : dirY < 0 ? -1 : 0;
+    float tMaxX = stepX > 0 ? ((cx + 1) * size - x) / dirX : stepX < 0 ? (cx * size - x) / dirX : INFINITY;
+    float tMaxY = stepY > 0 ? ((cy + 1) * size - y) / dirY : stepY < 0 ? (cy * size - y) / dirY : INFINITY;
+    float tDeltaX = stepX ? size / fabsf(dirX) : INFINITY;
+    float tDeltaY = stepY ? size / fabsf(dirY) : INFINITY;
+    int prevX = 0, prevY = 0;
+    bool first = true;
+    while (true) {
+        for (int ny = cy - 1; ny <= cy + 1; ny++) {
+            for (int nx = cx - 1; nx <= cx + 1; nx++) {
+                if (!first && abs(nx - prevX) <= 1 && abs(ny - prevY) <= 1) continue;
+                _LE_GridCell* cell = _LE_GridFind(grid, nx, ny);
+                if (!cell || cell->count == 0) continue;
+                if (!_LE_GridVisitCell(cell, visitor, userdata)) return false;
+            }
+        }
+        prevX = cx;
+        prevY = cy;
+        first = false;
+        float limit = (exit < *maxDistance ? exit : *maxDistance) - enter;
+        if (tMaxX < tMaxY) {
+            if (tMaxX > limit) break;
+            cx += stepX;
+            tMaxX += tDeltaX;
+        }
+        else {
+            if (tMaxY > limit) break;
+            cy += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+    return true;
+}
+
+void _LE_EntityGridInsert(_LE_EntityListData* data, _LE_Entity* entity) {
+    entity->staticCell = entity->flags & LE_EntityFlags_Static;
+    _LE_GridInsert(entity->staticCell ? &data->staticGrid : &data->grid, entity);
+}
+
+void _LE_EntityGridRemove(_LE_EntityListData* data, _LE_Entity* entity) {
+    _LE_GridRemove(entity->staticCell ? &data->staticGrid : &data->grid, entity);
+}
+
+void _LE_EntityGridUpdate(_LE_EntityListData* data, _LE_Entity* entity, bool moved) {
+    if (entity->staticCell != !!(entity->flags & LE_EntityFlags_Static)) {
+        _LE_EntityGridRemove(data, entity);
+        _LE_EntityGridInsert(data, entity);
+    }
+    else if (!entity->staticCell) _LE_GridUpdate(&data->grid, entity);
+    else if (moved) _LE_GridUpdate(&data->staticGrid, entity);
+}
+
+bool _LE_EntityGridQuery(_LE_EntityListData* data, float x1, float y1, float x2, float y2, _LE_GridVisitor visitor, void* userdata) {
+    if (!_LE_GridQuery(&data->grid, x1, y1, x2, y2, visitor, userdata)) return false;
+    return _LE_GridQuery(&data->staticGrid, x1, y1, x2, y2, visitor, userdata);
+}
+
+bool _LE_EntityGridRaycast(_LE_EntityListData* data, float x, float y, float dirX, float dirY, float* maxDistance, _LE_GridVisitor visitor, void* userdata) {
+    if (!_LE_GridRaycast(&data->grid, x, y, dirX, dirY, maxDistance, visitor, userdata)) return false;
+    return _LE_GridRaycast(&data->staticGrid, x, y, dirX, dirY, maxDistance, visitor, userdata);
+}
+
+static bool _LE_DrawCandidateVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_EntityListData* data = userdata;
+    if (!entity->deleted) _LE_PushEntity(&data->drawCandidates, &data->numDrawCandidates, &data->drawCandidateCapacity, entity);
+    return true;
+}
+
+static int _LE_CompareDrawIndex(const void* left, const void* right) {
+    int l = (*(_LE_Entity**)left)->drawIndex;
+    int r = (*(_LE_Entity**)right)->drawIndex;
+    return (l > r) - (l < r);
+}
+
+_LE_Entity** _LE_EntityListDrawCandidates(LE_EntityList* list, float x1, float y1, float x2, float y2, int tileW, int tileH, int* count) {
+    _LE_EntityListData* data = LE_ENTITY_LIST_DATA(list);
+    int num;
+    _LE_EntityListDrawOrder(list, &num);
+    float step = fmaxf(data->maxStep, data->idleStep);
+    float marginX = data->maxSpriteW / tileW / 2 + step;
+    float marginY = data->maxSpriteH / tileH + step;
+    data->numDrawCandidates = 0;
+    _LE_EntityGridQuery(data, x1 - marginX, y1 - step, x2 + marginX, y2 + marginY, _LE_DrawCandidateVisitor, data);
+    if (data->numDrawCandidates > 1) qsort(data->drawCandidates, data->numDrawCandidates, sizeof(_LE_Entity*), _LE_CompareDrawIndex);
+    *count = data->numDrawCandidates;
+    return data->drawCandidates;
+}
+
+typedef struct {
+    EntityQueryFilter filter;
+    void* userdata;
+    LE_Entity** out;
+    int max, count;
+    float x1, y1, x2, y2;
+    float radius;
+} _LE_EntityQuery;
+
+typedef struct {
+    EntityQueryFilter filter;
+    void* userdata;
+    LE_RaycastHit* out;
+    int max, count;
+    float x, y, dirX, dirY, maxDistance;
+} _LE_EntityRaycast;
+
+static bool _LE_QueryAccepts(_LE_Entity* entity, EntityQueryFilter filter, void* userdata) {
+    if (entity->deleted) return false;
+    return !filter || filter((LE_Entity*)entity, userdata);
+}
+
+static bool _LE_QueryRectVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_EntityQuery* query = userdata;
+    if (!LE_RectIntersectsRect(
+        entity->posX - entity->width / 2, entity->posY - entity->height, entity->posX + entity->width / 2, entity->posY,
+        query->x1, query->y1, query->x2, query->y2
+    )) return true;
+    if (!_LE_QueryAccepts(entity, query->filter, query->userdata)) return true;
+    query->out[query->count++] = (LE_Entity*)entity;
+    return query->count < query->max;
+}
+
+static bool _LE_QueryPointVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_EntityQuery* query = userdata;
+    if (query->x1 < entity->posX - entity->width / 2 || query->x1 > entity->posX + entity->width / 2) return true;
+    if (query->y1 < entity->posY - entity->height    || query->y1 > entity->posY) return true;
+    if (!_LE_QueryAccepts(entity, query->filter, query->userdata)) return true;
+    query->out[query->count++] = (LE_Entity*)entity;
+    return query->count < query->max;
+}
+
+static bool _LE_QueryRadiusVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_EntityQuery* query = userdata;
+    float x = query->x1, y = query->y1;
+    if (x < entity->posX - entity->width / 2) x = entity->posX - entity->width / 2;
+    if (x > entity->posX + entity->width / 2) x = entity->posX + entity->width / 2;
+    if (y < entity->posY - entity->height) y = entity->posY - entity->height;
+    if (y > entity->posY) y = entity->posY;
+    x -= query->x1;
+    y -= query->y1;
+    if (x * x + y * y > query->radius * query->radius) return true;
+    if (!_LE_QueryAccepts(entity, query->filter, query->userdata)) return true;
+    query->out[query->count++] = (LE_Entity*)entity;
+    return query->count < query->max;
+}
+
+static bool _LE_RaycastVisitor(_LE_Entity* entity, void* userdata) {
+    _LE_EntityRaycast* query = userdata;
+    float distance;
+    LE_Direction direction;
+    if (!LE_RayIntersectsRect(query->x, query->y, query->dirX, query->dirY, query->maxDistance,
+        entity->posX - entity->width / 2, entity->posY - entity->height, entity->posX + entity->width / 2, entity->posY,
+        &distance, &direction
+    )) return true;
+    if (query->count == query->max && distance >= query->out[query->max - 1].distance) return true;
+    if (!_LE_QueryAccepts(entity, query->filter, query->userdata)) return true;
+    int index = query->count < query->max ? query->count++ : query->max - 1;
+    while (index > 0 && query->out[index - 1].distance > distance) {
+        query->out[index] = query->out[index - 1];
+        index--;
+    }
+    query->out[index] = (LE_RaycastHit){
+        .entity = (LE_Entity*)entity, .tileX = 0, .tileY = 0,
+        .distance = distance, .hitX = query->x + query->dirX * distance, .hitY = query->y + query->dirY * distance,
+        .direction = direction
+    };
+    if (query->count == query->max) query->maxDistance = query->out[query->max - 1].distance;
+    return true;
+}
+
+int LE_EntityListQueryRect(LE_EntityList* list, float x1, float y1, float x2, float y2, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max) {
+    if (max <= 0) return 0;
+    _LE_EntityQuery query = { filter, userdata, out, max, 0, x1, y1, x2, y2, 0 };
+    _LE_EntityGridQuery(LE_ENTITY_LIST_DATA(list), x1, y1, x2, y2, _LE_QueryRectVisitor, &query);
+    return query.count;
+}
+
+int LE_EntityListQueryPoint(LE_EntityList* list, float x, float y, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max) {
+    if (max <= 0) return 0;
+    _LE_EntityQuery query = { filter, userdata, out, max, 0, x, y, x, y, 0 };
+    _LE_EntityGridQuery(LE_ENTITY_LIST_DATA(list), x, y, x, y, _LE_QueryPointVisitor, &query);
+    return query.count;
+}
+
+int LE_EntityListQueryRadius(LE_EntityList* list, float x, float y, float radius, EntityQueryFilter filter, void* userdata, LE_Entity** out, int max) {
+    if (max <= 0) return 0;
+    _LE_EntityQuery query = { filter, userdata, out, max, 0, x, y, x, y, radius };
+    _LE_EntityGridQuery(LE_ENTITY_LIST_DATA(list), x - radius, y - radius, x + radius, y + radius, _LE_QueryRadiusVisitor, &query);
+    return query.count;
+}
+
+int LE_EntityListRaycast(LE_EntityList* list, float x, float y, float dirX, float dirY, float maxDistance, EntityQueryFilter filter, void* userdata, LE_RaycastHit* out, int max) {
+    float length = sqrtf(dirX * dirX + dirY * dirY);
+    if (max <= 0 || length == 0) return 0;
+    _LE_EntityRaycast query = { filter, userdata, out, max, 0, x, y, dirX / length, dirY / length, maxDistance };
+    _LE_EntityGridRaycast(LE_ENTITY_LIST_DATA(list), x, y, query.dirX, query.dirY, &query.maxDistance, _LE_RaycastVisitor, &query);
+    return query.count;
+}
@@ -0,0 +1,38 @@
+#ifndef LUNAR_ENGINE_SPATIAL_H
+#define LUNAR_ENGINE_SPATIAL_H
+
+#include <stdbool.h>
+
+struct _LE_Entity;
+
+typedef struct _LE_GridCell {
+    int x, y;
+    int count;
+    struct _LE_Entity* head;
+    bool queued;
+    struct _LE_GridCell* nextEmpty;
+} _LE_GridCell;
+
+typedef struct {
+    _LE_GridCell** cells;
+    int capacity, used;
+    int minX, minY, maxX, maxY;
+    float cellSize;
+    _LE_GridCell large;
+    _LE_GridCell* empty;
+    _LE_GridCell* spare;
+    int numSpare;
+} _LE_Grid;
+
+typedef bool(*_LE_GridVisitor)(struct _LE_Entity* entity, void* userdata);
+
+void _LE_GridInit(_LE_Grid* grid, float cellSize);
+void _LE_GridFree(_LE_Grid* grid);
+void _LE_GridInsert(_LE_Grid* grid, struct _LE_Entity* entity);
+void _LE_GridRemove(_LE_Grid* grid, struct _LE_Entity* entity);
+void _LE_GridUpdate(_LE_Grid* grid, struct _LE_Entity* entity);
+void _LE_GridReclaim(_LE_Grid* grid);
+bool _LE_GridRaycast(_LE_Grid* grid, float x, float y, float dirX, float dirY, float* maxDistance, _LE_GridVisitor visitor, void* userdata);
+bool _LE_GridQuery(_LE_Grid* grid, float x1, float y1, float x2, float y2, _LE_GridVisitor visitor, void* userdata);
+
+#endif
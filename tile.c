@@ -1,37 +1,18 @@
+#include <math.h>
 #include <stdlib.h>
 
 #include "linked_list.h"
 #include "lunarengine.h"
-
-typedef DEFINE_LIST(TileTextureCallback) TexCallbackList;
-typedef DEFINE_LIST(TileCollisionCallback) CollCallbackList;
-
-typedef struct {
-    TexCallbackList* textureCallbacks;
-    CollCallbackList* collisionCallbacks;
-    bool solid;
-} _LE_TileData;
-
-typedef DEFINE_LIST(_LE_TileData) _LE_TileList;
-
-typedef struct {
-    void* texture;
-    int tilesInRow;
-    int tileWidth;
-    int tileHeight;
-    _LE_TileList* tiles;
-} _LE_Tileset;
-
-typedef struct {
-    int width, height;
-    int* data;
-    _LE_Tileset* tileset;
-} _LE_Tilemap;
+#include "memory.h"
+#include "profile.h"
+#include "record.h"
+#include "tile.h"
 
 LE_TileData* LE_CreateTileData() {
-    _LE_TileData* data = malloc(sizeof(_LE_TileData));
+    _LE_TileData* data = _LE_Malloc(sizeof(_LE_TileData), LE_MemoryTag_Tile);
     data->textureCallbacks = LE_LL_Create();
     data->collisionCallbacks = LE_LL_Create();
+    data->contactCallbacks = LE_LL_Create();
     data->solid = false;
     return (LE_TileData*)data;
 }
@@ -44,6 +25,18 @@ void LE_TileAddCollisionCallback(LE_TileData* tile, TileCollisionCallback coll)
     LE_LL_Add(((_LE_TileData*)tile)->collisionCallbacks, coll);
 }
 
+void LE_TileAddContactCallback(LE_TileData* tile, TileContactCallback contact) {
+    LE_LL_Add(((_LE_TileData*)tile)->contactCallbacks, contact);
+}
+
+void LE_TileContactEvent(LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity, int tileX, int tileY, LE_Direction direction, LE_ContactPhase phase) {
+    ContactCallbackList* curr = ((_LE_TileData*)tile)->contactCallbacks->next;
+    while (curr) {
+        ((TileContactCallback)curr->value)(tile, tilemap, entity, tileX, tileY, direction, phase);
+        curr = curr->next;
+    }
+}
+
 void LE_TileCollisionEvent(LE_TileData* tile, LE_Tilemap* tilemap, LE_Entity* entity, int tileX, int tileY, LE_Direction direction) {
     CollCallbackList* curr = ((_LE_TileData*)tile)->collisionCallbacks->next;
     while (curr) {
@@ -82,17 +75,20 @@ bool LE_TileIsSolid(LE_TileData* tile) {
 void LE_DestroyTileData(LE_TileData* tile) {
     _LE_TileData* td = (_LE_TileData*)tile;
     LE_LL_Free(td->collisionCallbacks);
+    LE_LL_Free(td->contactCallbacks);
     LE_LL_Free(td->textureCallbacks);
-    free(tile);
+    _LE_Free(tile);
 }
 
 LE_Tileset* LE_CreateTileset() {
-    _LE_Tileset* tileset = malloc(sizeof(_LE_Tileset));
+    _LE_Tileset* tileset = _LE_Malloc(sizeof(_LE_Tileset), LE_MemoryTag_Tile);
     tileset->texture = NULL;
     tileset->tilesInRow = 0;
     tileset->tileWidth = 0;
     tileset->tileHeight = 0;
-    tileset->tiles = LE_LL_Create();
+    tileset->tiles = NULL;
+    tileset->numTiles = 0;
+    tileset->tileCapacity = 0;
     return (LE_Tileset*)tileset;
 }
 
@@ -115,35 +111,48 @@ void LE_TilesetGetTileSize(LE_Tileset* tileset, int* width, int* height) {
 }
 
 void LE_TilesetAddTile(LE_Tileset* tileset, LE_TileData* tile) {
-    LE_LL_Add(((_LE_Tileset*)tileset)->tiles, tile);
+    _LE_Tileset* ts = (_LE_Tileset*)tileset;
+    if (ts->numTiles == ts->tileCapacity) {
+        ts->tileCapacity = ts->tileCapacity ? ts->tileCapacity * 2 : 16;
+        ts->tiles = _LE_Realloc(ts->tiles, sizeof(_LE_TileData*) * ts->tileCapacity, LE_MemoryTag_Tile);
+    }
+    ts->tiles[ts->numTiles++] = (_LE_TileData*)tile;
 }
 
 LE_TileData* LE_TilesetGetData(LE_Tileset* tileset, int tileIndex) {
-    return (LE_TileData*)LE_LL_Get(((_LE_Tileset*)tileset)->tiles, tileIndex);
+    _LE_Tileset* ts = (_LE_Tileset*)tileset;
+    if (tileIndex < 0 || tileIndex >= ts->numTiles) return NULL;
+    return (LE_TileData*)ts->tiles[tileIndex];
 }
 
 void LE_DestroyTileset(LE_Tileset* tileset) {
-    LE_LL_Free(((_LE_Tileset*)tileset)->tiles);
-    free(tileset);
+    _LE_Free(((_LE_Tileset*)tileset)->tiles);
+    _LE_Free(tileset);
 }
 
 LE_Tilemap* LE_CreateTilemap(int width, int height) {
-    _LE_Tilemap* tilemap = malloc(sizeof(_LE_Tilemap));
+    _LE_Tilemap* tilemap = _LE_Malloc(sizeof(_LE_Tilemap), LE_MemoryTag_Tile);
     tilemap->width = width;
     tilemap->height = height;
-    tilemap->data = malloc(sizeof(int) * width * height);
+    tilemap->data = _LE_Malloc(sizeof(int) * width * height, LE_MemoryTag_Tile);
     tilemap->tileset = NULL;
+    tilemap->version = 0;
+    tilemap->recording = NULL;
     return (LE_Tilemap*)tilemap;
 }
 
 void LE_TilemapSetTileset(LE_Tilemap* tilemap, LE_Tileset* tileset) {
     ((_LE_Tilemap*)tilemap)->tileset = (_LE_Tileset*)tileset;
+    ((_LE_Tilemap*)tilemap)->version++;
 }
 
 void LE_TilemapSetTile(LE_Tilemap* tilemap, int x, int y, int tile) {
     _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
     if (x < 0 || y < 0 || x >= t->width || y >= t->height) return;
+    if (t->data[y * t->width + x] == tile) return;
     t->data[y * t->width + x] = tile;
+    t->version++;
+    if (t->recording) _LE_RecordTile(t->recording, t->recordIndex, x, y, tile);
 }
 
 int LE_TilemapGetTile(LE_Tilemap* tilemap, int x, int y) {
@@ -161,6 +170,7 @@ void LE_TilemapGetSize(LE_Tilemap* tilemap, int* width, int* height) {
 LE_TileData* LE_TilemapGetTileData(LE_Tilemap* tilemap, int x, int y) {
     _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
     if (x < 0 || y < 0 || x >= t->width || y >= t->height) return NULL;
+    LE_PROFILE_COUNT(_LE_Counter_TileLookups, 1);
     return LE_TilesetGetData((LE_Tileset*)t->tileset, t->data[y * t->width + x]);
 }
 
@@ -186,6 +196,108 @@ void LE_DrawPartialTilemap(LE_Tilemap* tilemap, float x, float y, int fromX, int
     }
 }
 
+static bool _LE_TileAccepts(_LE_Tilemap* tilemap, int x, int y, TileQueryFilter filter, void* userdata) {
+    if (x < 0 || y < 0 || x >= tilemap->width || y >= tilemap->height) return false;
+    LE_TileData* tile = LE_TilemapGetTileData((LE_Tilemap*)tilemap, x, y);
+    if (!tile || !LE_TileIsSolid(tile)) return false;
+    return !filter || filter(tile, x, y, userdata);
+}
+
+int LE_TilemapQueryRect(LE_Tilemap* tilemap, float x1, float y1, float x2, float y2, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max) {
+    _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
+    int count = 0;
+    if (!t->tileset) return 0;
+    int fromX = floorf(x1), fromY = floorf(y1);
+    int toX = ceilf(x2) - 1, toY = ceilf(y2) - 1;
+    if (fromX < 0) fromX = 0;
+    if (fromY < 0) fromY = 0;
+    if (toX >= t->width)  toX = t->width  - 1;
+    if (toY >= t->height) toY = t->height - 1;
+    for (int y = fromY; y <= toY && count < max; y++) {
+        for (int x = fromX; x <= toX && count < max; x++) {
+            if (!_LE_TileAccepts(t, x, y, filter, userdata)) continue;
+            out[count++] = (LE_TileCoord){ x, y };
+        }
+    }
+    return count;
+}
+
+int LE_TilemapQueryPoint(LE_Tilemap* tilemap, float x, float y, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max) {
+    _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
+    if (max <= 0 || !t->tileset) return 0;
+    int tileX = floorf(x), tileY = floorf(y);
+    if (!_LE_TileAccepts(t, tileX, tileY, filter, userdata)) return 0;
+    out[0] = (LE_TileCoord){ tileX, tileY };
+    return 1;
+}
+
+int LE_TilemapQueryRadius(LE_Tilemap* tilemap, float x, float y, float radius, TileQueryFilter filter, void* userdata, LE_TileCoord* out, int max) {
+    _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
+    int count = 0;
+    if (!t->tileset) return 0;
+    int fromX = floorf(x - radius), fromY = floorf(y - radius);
+    int toX = floorf(x + radius), toY = floorf(y + radius);
+    if (fromX < 0) fromX = 0;
+    if (fromY < 0) fromY = 0;
+    if (toX >= t->width)  toX = t->width  - 1;
+    if (toY >= t->height) toY = t->height - 1;
+    for (int tileY = fromY; tileY <= toY && count < max; tileY++) {
+        for (int tileX = fromX; tileX <= toX && count < max; tileX++) {
+            float dx = x < tileX ? tileX - x : x > tileX + 1 ? x - tileX - 1 : 0;
+            float dy = y < tileY ? tileY - y : y > tileY + 1 ? y - tileY - 1 : 0;
+            if (dx * dx + dy * dy > radius * radius) continue;
+            if (!_LE_TileAccepts(t, tileX, tileY, filter, userdata)) continue;
+            out[count++] = (LE_TileCoord){ tileX, tileY };
+        }
+    }
+    return count;
+}
+
+int LE_TilemapRaycast(LE_Tilemap* tilemap, float x, float y, float dirX, float dirY, float maxDistance, TileQueryFilter filter, void* userdata, LE_RaycastHit* out, int max) {
+    _LE_Tilemap* t = (_LE_Tilemap*)tilemap;
+    float length = sqrtf(dirX * dirX + dirY * dirY);
+    int count = 0;
+    if (max <= 0 || length == 0 || !t->tileset) return 0;
+    dirX /= length;
+    dirY /= length;
+    int tileX = floorf(x), tileY = floorf(y);
+    int stepX = dirX > 0 ? 1 : dirX < 0 ? -1 : 0;
+    int stepY = dirY > 0 ? 1 : dirY < 0 ? -1 : 0;
+    float tMaxX = stepX > 0 ? (tileX + 1 - x) / dirX : stepX < 0 ? (tileX - x) / dirX : INFINITY;
+    float tMaxY = stepY > 0 ? (tileY + 1 - y) / dirY : stepY < 0 ? (tileY - y) / dirY : INFINITY;
+    float tDeltaX = stepX ? 1 / fabsf(dirX) : INFINITY;
+    float tDeltaY = stepY ? 1 / fabsf(dirY) : INFINITY;
+    float distance = 0;
+    LE_Direction direction = fabsf(dirX) > fabsf(dirY)
+        ? (dirX > 0 ? LE_Direction_Left : LE_Direction_Right)
+        : (dirY > 0 ? LE_Direction_Up : LE_Direction_Down);
+    while (count < max && distance <= maxDistance) {
+        if (_LE_TileAccepts(t, tileX, tileY, filter, userdata)) {
+            out[count++] = (LE_RaycastHit){
+                .entity = NULL, .tileX = tileX, .tileY = tileY,
+                .distance = distance, .hitX = x + dirX * distance, .hitY = y + dirY * distance,
+                .direction = direction
+            };
+        }
+        if ((tileX < 0 && stepX <= 0) || (tileX >= t->width  && stepX >= 0)) break;
+        if ((tileY < 0 && stepY <= 0) || (tileY >= t->height && stepY >= 0)) break;
+        if (tMaxX < tMaxY) {
+            distance = tMaxX;
+            tileX += stepX;
+            tMaxX += tDeltaX;
+            direction = stepX > 0 ? LE_Direction_Left : LE_Direction_Right;
+        }
+        else {
+            distance = tMaxY;
+            tileY += stepY;
+            tMaxY += tDeltaY;
+            direction = stepY > 0 ? LE_Direction_Up : LE_Direction_Down;
+        }
+    }
+    return count;
+}
+
 void LE_DestroyTilemap(LE_Tilemap* tilemap) {
-    free(tilemap);
+    _LE_Free(((_LE_Tilemap*)tilemap)->data);
+    _LE_Free(tilemap);
 }
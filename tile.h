@@ -0,0 +1,36 @@
+#ifndef LUNAR_ENGINE_TILE_H
+#define LUNAR_ENGINE_TILE_H
+
+#include "linked_list.h"
+#include "lunarengine.h"
+
+typedef DEFINE_LIST(TileTextureCallback) TexCallbackList;
+typedef DEFINE_LIST(TileCollisionCallback) CollCallbackList;
+typedef DEFINE_LIST(TileContactCallback) ContactCallbackList;
+
+typedef struct {
+    TexCallbackList* textureCallbacks;
+    CollCallbackList* collisionCallbacks;
+    ContactCallbackList* contactCallbacks;
+    bool solid;
+} _LE_TileData;
+
+typedef struct {
+    void* texture;
+    int tilesInRow;
+    int tileWidth;
+    int tileHeight;
+    _LE_TileData** tiles;
+    int numTiles, tileCapacity;
+} _LE_Tileset;
+
+typedef struct {
+    int width, height;
+    int* data;
+    _LE_Tileset* tileset;
+    unsigned int version;
+    struct _LE_Recording* recording;
+    int recordIndex;
+} _LE_Tilemap;
+
+#endif
@@ -0,0 +1,223 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lunarengine.h"
+#include "memory.h"
+#include "record.h"
+#include "world.h"
+
+static void _LE_WorldTick(_LE_World* world) {
+    if (world->recording) _LE_RecordTickBegin(world->recording);
+    if (world->layers) LE_UpdateLayerList(world->layers);
+    if (world->callback) world->callback((LE_World*)world, world->userdata);
+    if (world->recording) _LE_RecordUpdateBegin(world->recording, world->tickDelta);
+    for (int i = 0; i < world->numLists; i++) {
+        LE_UpdateEntities(world->lists[i], world->tickDelta);
+    }
+    if (world->recording) _LE_RecordUpdateEnd(world->recording);
+    world->ticks++;
+}
+
+int _LE_WorldConsume(_LE_World* world, float seconds) {
+    if (seconds > 0) world->accumulator += seconds;
+    int ticks = world->accumulator / world->tickLength;
+    world->accumulator -= ticks * world->tickLength;
+    if (world->maxCatchUp > 0 && ticks > world->maxCatchUp) {
+        world->droppedTicks += ticks - world->maxCatchUp;
+        ticks = world->maxCatchUp;
+    }
+    if (world->accumulator < 0) world->accumulator = 0;
+    return ticks;
+}
+
+void _LE_WorldRunTicks(_LE_World* world, int ticks) {
+    if (ticks <= 0) return;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < ticks; i++) {
+        _LE_WorldTick(world);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    float cost = ((end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9) / ticks;
+    world->lastTickCost = cost;
+    world->avgTickCost = world->avgTickCost == 0 ? cost : world->avgTickCost + (cost - world->avgTickCost) * 0.1f;
+}
+
+static void* _LE_WorldThread(void* ptr) {
+    _LE_World* world = ptr;
+    pthread_mutex_lock(&world->lock);
+    while (true) {
+        while (!world->shutdown && world->pendingTicks == 0) pthread_cond_wait(&world->cond, &world->lock);
+        if (world->shutdown) break;
+        int ticks = world->pendingTicks;
+        pthread_mutex_unlock(&world->lock);
+        _LE_WorldRunTicks(world, ticks);
+        pthread_mutex_lock(&world->lock);
+        world->pendingTicks = 0;
+        pthread_cond_broadcast(&world->cond);
+    }
+    pthread_mutex_unlock(&world->lock);
+    return NULL;
+}
+
+static void _LE_WorldKick(_LE_World* world, int ticks) {
+    if (ticks == 0) return;
+    pthread_mutex_lock(&world->lock);
+    world->pendingTicks = ticks;
+    pthread_cond_broadcast(&world->cond);
+    pthread_mutex_unlock(&world->lock);
+}
+
+LE_World* LE_CreateWorld(LE_LayerList* layers) {
+    _LE_World* world = _LE_Malloc(sizeof(_LE_World), LE_MemoryTag_World);
+    memset(world, 0, sizeof(_LE_World));
+    world->layers = layers;
+    world->tickLength = 1.f / 60;
+    world->tickDelta = 1;
+    world->maxCatchUp = 5;
+    pthread_mutex_init(&world->lock, NULL);
+    pthread_cond_init(&world->cond, NULL);
+    return (LE_World*)world;
+}
+
+void LE_WorldAddEntityList(LE_World* world, LE_EntityList* list) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSync(world);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    if (w->numLists == w->listCapacity) {
+        w->listCapacity = w->listCapacity ? w->listCapacity * 2 : 4;
+        w->lists = _LE_Realloc(w->lists, sizeof(LE_EntityList*) * w->listCapacity, LE_MemoryTag_World);
+    }
+    w->lists[w->numLists++] = list;
+}
+
+void LE_WorldRemoveEntityList(LE_World* world, LE_EntityList* list) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSync(world);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    for (int i = 0; i < w->numLists; i++) {
+        if (w->lists[i] != list) continue;
+        memmove(w->lists + i, w->lists + i + 1, sizeof(LE_EntityList*) * (w->numLists - i - 1));
+        w->numLists--;
+        return;
+    }
+}
+
+void LE_WorldReplaceEntityList(LE_World* world, LE_EntityList* list, LE_EntityList* replacement) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSync(world);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    for (int i = 0; i < w->numLists; i++) {
+        if (w->lists[i] != list) continue;
+        w->lists[i] = replacement;
+        return;
+    }
+}
+
+LE_LayerList* LE_WorldGetLayers(LE_World* world) {
+    return ((_LE_World*)world)->layers;
+}
+
+void LE_WorldSetTickLength(LE_World* world, float seconds) {
+    if (seconds > 0) ((_LE_World*)world)->tickLength = seconds;
+}
+
+void LE_WorldSetTickDelta(LE_World* world, float delta) {
+    ((_LE_World*)world)->tickDelta = delta;
+}
+
+void LE_WorldSetMaxCatchUp(LE_World* world, int ticks) {
+    ((_LE_World*)world)->maxCatchUp = ticks;
+}
+
+void LE_WorldSetTickCallback(LE_World* world, WorldTickCallback callback, void* userdata) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSync(world);
+    w->callback = callback;
+    w->userdata = userdata;
+}
+
+void LE_WorldSetPipelined(LE_World* world, bool pipelined) {
+    _LE_World* w = (_LE_World*)world;
+    if (w->pipelined == pipelined) return;
+    if (pipelined) {
+        w->shutdown = false;
+        pthread_create(&w->thread, NULL, _LE_WorldThread, w);
+    }
+    else {
+        LE_WorldSync(world);
+        pthread_mutex_lock(&w->lock);
+        w->shutdown = true;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+    }
+    w->pipelined = pipelined;
+}
+
+void LE_WorldSync(LE_World* world) {
+    _LE_World* w = (_LE_World*)world;
+    if (!w->pipelined) return;
+    pthread_mutex_lock(&w->lock);
+    while (w->pendingTicks > 0) pthread_cond_wait(&w->cond, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+}
+
+int LE_WorldAdvance(LE_World* world, float seconds) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSync(world);
+    int ticks = _LE_WorldConsume(w, seconds);
+    if (w->pipelined) _LE_WorldKick(w, ticks);
+    else _LE_WorldRunTicks(w, ticks);
+    return ticks;
+}
+
+int LE_WorldFrame(LE_World* world, float seconds, int screenW, int screenH, LE_DrawList* dl) {
+    _LE_World* w = (_LE_World*)world;
+    if (!w->pipelined) {
+        int ticks = LE_WorldAdvance(world, seconds);
+        if (w->layers && dl) LE_Draw(w->layers, screenW, screenH, LE_WorldGetInterpolation(world), dl);
+        return ticks;
+    }
+    LE_WorldSync(world);
+    if (w->layers && dl) LE_Draw(w->layers, screenW, screenH, LE_WorldGetInterpolation(world), dl);
+    int ticks = _LE_WorldConsume(w, seconds);
+    _LE_WorldKick(w, ticks);
+    return ticks;
+}
+
+float LE_WorldGetInterpolation(LE_World* world) {
+    _LE_World* w = (_LE_World*)world;
+    float interpolation = w->accumulator / w->tickLength;
+    return interpolation > 1 ? 1 : interpolation;
+}
+
+unsigned long long LE_WorldGetTicks(LE_World* world) {
+    return ((_LE_World*)world)->ticks;
+}
+
+int LE_WorldGetDroppedTicks(LE_World* world) {
+    return ((_LE_World*)world)->droppedTicks;
+}
+
+float LE_WorldGetTickCost(LE_World* world, float* last) {
+    _LE_World* w = (_LE_World*)world;
+    if (last) *last = w->lastTickCost;
+    return w->avgTickCost;
+}
+
+void LE_DestroyWorld(LE_World* world) {
+    _LE_World* w = (_LE_World*)world;
+    LE_WorldSetPipelined(world, false);
+    if (w->recording) LE_RecordingStop((LE_Recording*)w->recording);
+    for (int i = 0; i < w->numLists; i++) {
+        LE_DestroyEntityList(w->lists[i]);
+    }
+    if (w->layers) LE_DestroyLayerList(w->layers);
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->cond);
+    _LE_Free(w->lists);
+    _LE_Free(w);
+}
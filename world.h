@@ -0,0 +1,34 @@
+#ifndef LUNAR_ENGINE_WORLD_H
+#define LUNAR_ENGINE_WORLD_H
+
+#include <pthread.h>
+
+#include "lunarengine.h"
+
+typedef struct {
+    LE_LayerList* layers;
+    LE_EntityList** lists;
+    int numLists, listCapacity;
+    float tickLength;
+    float tickDelta;
+    int maxCatchUp;
+    float accumulator;
+    WorldTickCallback callback;
+    void* userdata;
+    unsigned long long ticks;
+    int droppedTicks;
+    float lastTickCost;
+    float avgTickCost;
+    bool pipelined;
+    bool shutdown;
+    int pendingTicks;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct _LE_Recording* recording;
+} _LE_World;
+
+int  _LE_WorldConsume(_LE_World* world, float seconds);
+void _LE_WorldRunTicks(_LE_World* world, int ticks);
+
+#endif